@@ -0,0 +1,206 @@
+/**************************************************************
+ *
+ * Host benchmark of the receive FIFO (TinyGsmFifo)
+ *
+ * This is not an Arduino sketch; build and run it on a PC:
+ *   g++ -std=gnu++11 -O2 -I../../../src FifoBenchmark.cpp -o bench
+ *   ./bench
+ *
+ * It first checks each FIFO against a std::deque over 300000
+ * random puts, gets, peeks and span accesses:
+ *   - the modulo version used for sizes that aren't a power of
+ *     two (and before, for every size),
+ *   - the power of two version,
+ *   - the power of two version with its positions a little
+ *     short of UINT_MAX, so they wrap around during the check.
+ * It then times the modulo version against the power of two
+ * version at the default TINY_GSM_RX_BUFFER size of 64.
+ *
+ **************************************************************/
+
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <random>
+
+#include "TinyGsmFifo.h"
+
+static const int OPS = 300000;
+
+// The modulo version the power of two sizes used to get
+typedef TinyGsmFifo<uint8_t, 64, false> ModuloFifo;
+typedef TinyGsmFifo<uint8_t, 64>        MaskFifo;
+typedef TinyGsmFifo<uint8_t, 48>        OddFifo;
+
+// Run the same random operations on the FIFO and a deque, and check they
+// always agree; the modulo version holds one item fewer than its size
+template <class Fifo>
+static bool check(Fifo& fifo, size_t capacity, uint32_t seed) {
+  std::mt19937        rng(seed);
+  std::deque<uint8_t> ref;
+  uint8_t             next = 0;
+  uint8_t             buf[80];
+  for (int op = 0; op < OPS; op++) {
+    int n = rng() % 80;
+    switch (rng() % 8) {
+      case 0: {
+        bool added = fifo.put(next);
+        if (added != (ref.size() < capacity)) { return false; }
+        if (added) { ref.push_back(next++); }
+        break;
+      }
+      case 1: {
+        for (int i = 0; i < n; i++) { buf[i] = next + i; }
+        int added = fifo.put(buf, n);
+        if (static_cast<size_t>(added) !=
+            std::min(static_cast<size_t>(n), capacity - ref.size())) {
+          return false;
+        }
+        for (int i = 0; i < added; i++) { ref.push_back(next++); }
+        break;
+      }
+      case 2: {
+        size_t   len;
+        uint8_t* span = fifo.writeSpan(len);
+        if (len > capacity - ref.size() || (!len && ref.size() < capacity)) {
+          return false;
+        }
+        size_t used = len ? rng() % (len + 1) : 0;
+        for (size_t i = 0; i < used; i++) {
+          span[i] = next;
+          ref.push_back(next++);
+        }
+        fifo.commit(used);
+        break;
+      }
+      case 3: {
+        uint8_t item;
+        bool    taken = fifo.get(&item);
+        if (taken != !ref.empty()) { return false; }
+        if (taken) {
+          if (item != ref.front()) { return false; }
+          ref.pop_front();
+        }
+        break;
+      }
+      case 4: {
+        int taken = fifo.get(buf, n);
+        if (static_cast<size_t>(taken) !=
+            std::min(static_cast<size_t>(n), ref.size())) {
+          return false;
+        }
+        for (int i = 0; i < taken; i++) {
+          if (buf[i] != ref.front()) { return false; }
+          ref.pop_front();
+        }
+        break;
+      }
+      case 5: {
+        size_t         len;
+        const uint8_t* span = fifo.readSpan(len);
+        if (len > ref.size() || (!len && !ref.empty())) { return false; }
+        size_t used = len ? rng() % (len + 1) : 0;
+        for (size_t i = 0; i < used; i++) {
+          if (span[i] != ref.front()) { return false; }
+          ref.pop_front();
+        }
+        fifo.consume(used);
+        break;
+      }
+      case 6:
+        if (fifo.peek() != (ref.empty() ? -1 : ref.front())) { return false; }
+        break;
+      default:
+        if (rng() % 64 == 0) {
+          fifo.clear();
+          ref.clear();
+        }
+        break;
+    }
+    if (fifo.size() != ref.size() ||
+        static_cast<size_t>(fifo.free()) != capacity - ref.size() ||
+        fifo.readable() != !ref.empty() ||
+        fifo.writeable() != (ref.size() < capacity)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Move the positions of an empty power of two FIFO on to a little short of
+// UINT_MAX, a full buffer at a time
+static void advance(MaskFifo& fifo) {
+  const unsigned target = UINT_MAX - 4096;
+  for (unsigned done = 0; target - done >= 64; done += 64) {
+    size_t len;
+    fifo.writeSpan(len);
+    fifo.commit(len);
+    fifo.readSpan(len);
+    fifo.consume(len);
+  }
+}
+
+// ns per byte to pass a stream through the FIFO in pieces of the given size,
+// with put()/get() of one byte at a time when the size is 1
+template <class Fifo>
+static double timeFifo(int piece, bool spans) {
+  static const size_t TOTAL = 64 * 1024 * 1024;
+  Fifo                fifo;
+  uint8_t             buf[64];
+  memset(buf, 0x5A, sizeof(buf));
+  volatile uint32_t sink  = 0;
+  auto              start = std::chrono::steady_clock::now();
+  for (size_t moved = 0; moved < TOTAL;) {
+    if (spans) {
+      size_t   len;
+      uint8_t* w = fifo.writeSpan(len);
+      if (len > static_cast<size_t>(piece)) { len = piece; }
+      memcpy(w, buf, len);
+      fifo.commit(len);
+      const uint8_t* r = fifo.readSpan(len);
+      if (len > static_cast<size_t>(piece)) { len = piece; }
+      sink = sink + r[0];
+      fifo.consume(len);
+      moved += len;
+    } else if (piece == 1) {
+      uint8_t c = 0;
+      fifo.put(buf[0]);
+      fifo.get(&c);
+      sink = sink + c;
+      moved++;
+    } else {
+      fifo.put(buf, piece);
+      int n = fifo.get(buf, piece);
+      sink  = sink + buf[0];
+      moved += n;
+    }
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - start).count() / TOTAL;
+}
+
+int main() {
+  ModuloFifo modulo;
+  MaskFifo   mask;
+  OddFifo    odd;
+  MaskFifo   wrapping;
+  advance(wrapping);
+  if (!check(modulo, 63, 1) || !check(mask, 64, 2) || !check(odd, 47, 3) ||
+      !check(wrapping, 64, 4)) {
+    printf("A FIFO and the deque disagree!\n");
+    return 1;
+  }
+  printf("All of the FIFOs agree with the deque over %d operations each\n",
+         OPS);
+
+  printf("%-22s %12s %12s\n", "ns per byte, size 64", "modulo", "power of 2");
+  printf("%-22s %12.2f %12.2f\n", "put()/get() a byte",
+         timeFifo<ModuloFifo>(1, false), timeFifo<MaskFifo>(1, false));
+  printf("%-22s %12.2f %12.2f\n", "put()/get() 17 bytes",
+         timeFifo<ModuloFifo>(17, false), timeFifo<MaskFifo>(17, false));
+  printf("%-22s %12.2f %12.2f\n", "spans of 17 bytes",
+         timeFifo<ModuloFifo>(17, true), timeFifo<MaskFifo>(17, true));
+  return 0;
+}
@@ -0,0 +1,126 @@
+/**************************************************************
+ *
+ * Host benchmark of the response matcher (TinyGsmMatcher)
+ *
+ * This is not an Arduino sketch; build and run it on a PC:
+ *   g++ -std=gnu++11 -O2 -I../../../src MatcherBenchmark.cpp -o bench
+ *   ./bench
+ *
+ * It first checks the matcher against calling endsWith() for
+ * every pattern on every character, on random text, and then
+ * times:
+ *   - the endsWith() loop the matcher replaced,
+ *   - the matcher working out its fall backs from the patterns,
+ *   - the matcher with its fall back tables.
+ *
+ **************************************************************/
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+
+// Stand in for the parts of TinyGsmCommon.h the matcher uses, so this builds
+// without the Arduino core
+#define SRC_TINYGSMCOMMON_H_
+typedef const char* GsmConstStr;
+#define TINY_GSM_PGM_LEN(s) strlen(s)
+#define TINY_GSM_PGM_CHAR(s, i) ((s)[i])
+#include "TinyGsmMatcher.h"
+
+static const uint8_t PATTERNS = 10;
+
+static const char* patterns[PATTERNS] = {
+    "OK\r\n",         "ERROR\r\n",      "+CME ERROR:", "+CMS ERROR:",
+    "\r\n+CIPRXGET:", "CLOSED\r\n",     "SEND OK\r\n", "\r\n+CPIN: ",
+    "aab",            "abababababac"};  // the last two overlap themselves
+
+// The first pattern the text ends with, as the old loop found it
+static int8_t endsWithAny(const std::string& text) {
+  for (uint8_t i = 0; i < PATTERNS; i++) {
+    size_t len = strlen(patterns[i]);
+    if (text.size() >= len &&
+        text.compare(text.size() - len, len, patterns[i]) == 0) {
+      return i + 1;
+    }
+  }
+  return 0;
+}
+
+template <class Matcher>
+static bool check(uint32_t seed) {
+  std::mt19937 rng(seed);
+  const char   alphabet[] = "OKERabc\r\n+C:";
+  for (int run = 0; run < 2000; run++) {
+    Matcher m;
+    for (uint8_t i = 0; i < PATTERNS; i++) { m.add(patterns[i]); }
+    std::string text;
+    for (int n = 0; n < 300; n++) {
+      char c = alphabet[rng() % (sizeof(alphabet) - 1)];
+      text += c;
+      if (m.step(c) != endsWithAny(text)) { return false; }
+    }
+  }
+  return true;
+}
+
+template <class Matcher>
+static double timeMatcher(const std::string& in, int rounds) {
+  volatile int sink  = 0;
+  auto         start = std::chrono::steady_clock::now();
+  for (int r = 0; r < rounds; r++) {
+    Matcher m;
+    for (uint8_t i = 0; i < PATTERNS; i++) { m.add(patterns[i]); }
+    for (char c : in) { sink = sink + m.step(c); }
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - start).count() /
+      (static_cast<double>(in.size()) * rounds);
+}
+
+static double timeEndsWith(const std::string& in, int rounds) {
+  volatile int sink  = 0;
+  auto         start = std::chrono::steady_clock::now();
+  for (int r = 0; r < rounds; r++) {
+    std::string text;
+    for (char c : in) {
+      text += c;
+      // the response buffer only ever kept the last 64 characters
+      if (text.size() > 64) { text.erase(0, text.size() - 64); }
+      sink = sink + endsWithAny(text);
+    }
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - start).count() /
+      (static_cast<double>(in.size()) * rounds);
+}
+
+typedef TinyGsmMatcher<PATTERNS, 0>   ScanMatcher;
+typedef TinyGsmMatcher<PATTERNS, 256> TableMatcher;
+
+int main() {
+  if (!check<ScanMatcher>(1) || !check<TableMatcher>(1)) {
+    printf("The matcher and endsWith() disagree!\n");
+    return 1;
+  }
+
+  // ordinary AT traffic, and text that keeps the self-overlapping pattern
+  // partly matched so every mismatch falls back a long way
+  std::string at, overlap;
+  for (int i = 0; i < 200; i++) {
+    at += "+CSQ: 21,99\r\n\r\nOK\r\n\r\n+CREG: 0,1\r\nsome data payload\r\n";
+    overlap += "abababababab";
+  }
+  const int rounds = 200;
+  printf("%-22s %12s %12s\n", "ns per character", "AT traffic", "overlapping");
+  printf("%-22s %12.2f %12.2f\n", "endsWith() loop", timeEndsWith(at, rounds),
+         timeEndsWith(overlap, rounds));
+  printf("%-22s %12.2f %12.2f\n", "matcher, no tables",
+         timeMatcher<ScanMatcher>(at, rounds),
+         timeMatcher<ScanMatcher>(overlap, rounds));
+  printf("%-22s %12.2f %12.2f\n", "matcher, tables",
+         timeMatcher<TableMatcher>(at, rounds),
+         timeMatcher<TableMatcher>(overlap, rounds));
+  return 0;
+}
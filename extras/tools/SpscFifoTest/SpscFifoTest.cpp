@@ -0,0 +1,117 @@
+/**************************************************************
+ *
+ * Host test of the lock-free FIFO (TinyGsmSpscFifo)
+ *
+ * This is not an Arduino sketch; build and run it on a PC:
+ *   g++ -std=gnu++11 -O2 -pthread -I../../../src SpscFifoTest.cpp -o test
+ *   ./test
+ * and again under ThreadSanitizer, which reports any access to
+ * the buffer that the acquire/release ordering doesn't cover:
+ *   g++ -std=gnu++11 -O1 -g -fsanitize=thread -pthread \
+ *       -I../../../src SpscFifoTest.cpp -o test_tsan
+ *   ./test_tsan
+ *
+ * A producer thread writes a running count into the FIFO while
+ * a consumer thread reads it back, each switching between the
+ * single item, block and span functions; the consumer checks
+ * that every number arrives once and in order.  A small FIFO
+ * is used so both sides keep finding it full or empty; a side
+ * that finds nothing to do yields, so this also runs on a
+ * single core.
+ *
+ **************************************************************/
+
+#include <cstdio>
+#include <thread>
+
+#include "TinyGsmSpscFifo.h"
+
+static const uint32_t ITEMS = 10000000;
+
+typedef TinyGsmSpscFifo<uint32_t, 16> Fifo;
+
+static void produce(Fifo& fifo) {
+  uint32_t next = 0;
+  uint32_t block[7];
+  for (uint32_t round = 0; next < ITEMS; round++) {
+    uint32_t before = next;
+    switch (round % 3) {
+      case 0:
+        if (fifo.put(next)) { next++; }
+        break;
+      case 1: {
+        int n = 0;
+        for (; n < 7 && next + n < ITEMS; n++) { block[n] = next + n; }
+        next += fifo.put(block, n);
+        break;
+      }
+      default: {
+        size_t    len;
+        uint32_t* span = fifo.writeSpan(len);
+        size_t    i    = 0;
+        for (; i < len && next < ITEMS; i++) { span[i] = next++; }
+        fifo.commit(i);
+        break;
+      }
+    }
+    if (next == before) { std::this_thread::yield(); }
+  }
+}
+
+static bool consume(Fifo& fifo) {
+  uint32_t next = 0;
+  uint32_t item;
+  uint32_t block[5];
+  for (uint32_t round = 0; next < ITEMS; round++) {
+    uint32_t before = next;
+    switch (round % 4) {
+      case 0:
+        if (fifo.get(&item)) {
+          if (item != next) { return false; }
+          next++;
+        }
+        break;
+      case 1: {
+        int n = fifo.get(block, 5);
+        for (int i = 0; i < n; i++) {
+          if (block[i] != next) { return false; }
+          next++;
+        }
+        break;
+      }
+      case 2: {
+        size_t          len;
+        const uint32_t* span = fifo.readSpan(len);
+        for (size_t i = 0; i < len; i++) {
+          if (span[i] != next) { return false; }
+          next++;
+        }
+        fifo.consume(len);
+        break;
+      }
+      default: {
+        int p = fifo.peek();
+        if (p >= 0 && static_cast<uint32_t>(p) != next) { return false; }
+        break;
+      }
+    }
+    if (next == before && round % 4 != 3) { std::this_thread::yield(); }
+  }
+  return !fifo.readable();
+}
+
+int main() {
+  Fifo        fifo;
+  bool        ok = false;
+  std::thread consumer([&] { ok = consume(fifo); });
+  std::thread producer([&] { produce(fifo); });
+  producer.join();
+  consumer.join();
+  if (!ok) {
+    printf("The items came out of the FIFO wrong!\n");
+    return 1;
+  }
+  printf("%lu items passed through in order\n",
+         static_cast<unsigned long>(ITEMS));
+  return 0;
+}
@@ -6,12 +6,23 @@
  **************************************************************/
 #define TINY_GSM_DEBUG Serial
 #define TINY_GSM_DEBUG_DEEP
+#define TINY_GSM_STATS
 
 #include <TinyGsmClient.h>
 #include <TinyGsmEnums.h>
+#include <TinyGsmCoroutine.h>
+#include <TinyGsmSpscFifo.h>
 
 TinyGsm modem(Serial);
 
+void onNewSMS(Stream& stream) {
+  stream.readStringUntil('\n');
+}
+
+void onCommandDone(TinyGsmCommand& command) {
+  command.response().indexOf(',');
+}
+
 void setup() {
   Serial.begin(115200);
   delay(6000);
@@ -28,12 +39,55 @@ void loop() {
   modem.waitResponse(1000L, waitData);
   modem.waitResponse(1000L);
   modem.waitResponse();
+  TinyGsmBatch<3> batch;
+  batch.add(GF("+CMEE=2"));
+  batch.add(GF("+CGDCONT=1,\"IP\",\""), "myAPN", GF("\""), 5000L);
+  batch.add(GF("+CSQ"), 1000L, GF("+CSQ:"));
+  modem.sendBatch(batch);
+  batch.result(1);
+  TinyGsmCommand attach(GF("+CGATT=1"), 60000L);
+  attach.onDone(onCommandDone);
+  TinyGsmCommand csq;
+  csq.set(GF("+CSQ"));
+  csq.expect(GF("+CSQ:"));
+  modem.submit(attach);
+  modem.submit(csq);
+  while (modem.poll()) {}
+  modem.busy();
+  attach.done();
+  csq.result();
+  TinyGsmFields<4> fields;
+  fields.parse("+CSQ: 20,0");
+  fields.toInt(1);
+  fields.toFixed(0, 2);
+  fields.toFloat(0);
+  modem.getStats().find("+CSQ");
+  modem.getStats().commands[0].percentile(95);
+  modem.dumpStats(Serial);
+  modem.resetStats();
+  TinyGsmFifo<uint8_t, 16> fifo;
+  size_t                   spanLen;
+  fifo.writeSpan(spanLen)[0] = 'A';
+  fifo.commit(1);
+  fifo.readSpan(spanLen);
+  fifo.consume(spanLen);
+#ifdef TINY_GSM_HAS_ATOMIC
+  static TinyGsmSpscFifo<uint8_t, 64> spsc;
+  spsc.put('A');
+  spsc.writeSpan(spanLen);
+  spsc.commit(0);
+  spsc.readSpan(spanLen);
+  spsc.consume(spanLen);
+  spsc.clear();
+#endif
   TinyGsmAutoBaud(Serial, 9600, 115200);
   modem.forceModemBaud(Serial, 115200);
   modem.setBaud(115200);
   modem.testAT();
   modem.streamWrite("AT", "\r\n");
   modem.streamClear();
+  modem.registerURC(GF("+CMTI:"), onNewSMS);
+  modem.unregisterURC(GF("+CMTI:"));
 
   modem.getModemInfo();
   modem.getModemName();
@@ -138,6 +192,26 @@ void loop() {
   client.endWrite(63);
 #endif
 
+  // Or gather the pieces into as few sends as possible
+  TinyGsmIoVec request[] = {{"GET "}, {resource}, {F(" HTTP/1.0\r\nHost: ")},
+                            {server, strlen(server)},
+                            {F("\r\nConnection: close\r\n\r\n")}};
+  client.writev(request, 5);
+
+  // Check which sockets have something to read, all in one pass
+  TinyGsmSocketEvents events = modem.pollSockets(0x03, 100);
+  if (events.readable & 0x01) { client.read(); }
+
+  // Update the connection state of every socket at once
+  modem.refreshAllSockets();
+
+  // Start connecting without waiting, and wait once for all of them
+  client2.connectAsync(server, 80);
+  client3.connectAsync(server, 443);
+  if (client3.connecting()) { modem.waitConnects(); }
+  client2.stop();
+  client3.stop();
+
   uint32_t timeout = millis();
   while (client.connected() && millis() - timeout < 10000L) {
     while (client.available()) {
@@ -148,6 +222,27 @@ void loop() {
 
   client.stop();
 
+#if defined(TINY_GSM_MODEM_HAS_UDP)
+  // Test UDP functions
+  TinyGsmUDP udp(modem, 2);
+  TinyGsmUDP udp2;
+  udp2.init(&modem, 3);
+  udp.begin(5683);
+  udp.beginPacket(server, 5683);
+  udp.write(reinterpret_cast<const uint8_t*>("reading"), 7);
+  udp.print(21.5);
+  udp.endPacket();
+  udp.beginPacket(IPAddress(192, 168, 1, 1), 5683);
+  udp.endPacket();
+  if (udp.parsePacket()) {
+    char reply[16];
+    udp.read(reply, sizeof(reply));
+    udp.remoteIP();
+    udp.remotePort();
+  }
+  udp.stop();
+#endif
+
 #if defined(TINY_GSM_MODEM_HAS_SSL)
   TinyGsmClientSecure client_secure(modem);
   TinyGsmClientSecure client_secure2(modem);
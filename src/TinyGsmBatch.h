@@ -0,0 +1,176 @@
+/**
+ * @file       TinyGsmBatch.h
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ */
+
+#ifndef SRC_TINYGSMBATCH_H_
+#define SRC_TINYGSMBATCH_H_
+
+#include "TinyGsmCommon.h"
+
+/**
+ * @brief One command in a batch of AT commands.
+ *
+ * The command is sent as `cmd`, followed by `arg` and `tail` if they're given;
+ * i.e., `+CGDCONT=1,"IP","` + apn + `"`.
+ *
+ * The response is the last thing the module sends for the command (ie, "OK"
+ * or "SHUT OK"); nothing the module sends with it is kept.
+ */
+struct TinyGsmBatchCommand {
+  GsmConstStr cmd;         ///< The command, without the leading "AT"
+  const char* arg;         ///< Text from RAM sent after the command; optional
+  GsmConstStr tail;        ///< Text sent after the argument; optional
+  GsmConstStr response;    ///< The final response expected; null for "OK"
+  uint32_t    timeout_ms;  ///< The time to wait for the response
+  /**
+   * @brief The result of the command: 1 if the expected response was
+   * received, 2 for "ERROR", 0 for a timeout and -1 if the command wasn't run
+   */
+  int8_t result;
+};
+
+/**
+ * @brief A list of AT commands to be sent to the module together, with the
+ * result of each one collected in order.
+ *
+ * Commands that only expect "OK" are concatenated onto a single command line
+ * (`AT+A;+B;+C`) when the module supports it, so a whole group of settings
+ * costs a single round trip.  See TinyGsmModem::sendBatch().
+ *
+ * This class holds the logic; the storage for the commands comes from
+ * TinyGsmBatch, which is sized at compile time.
+ */
+class TinyGsmCommandBatch {
+ public:
+  /**
+   * @brief Add a command to the batch
+   *
+   * @param cmd The command, without the leading "AT"
+   * @param timeout_ms The time to wait for the response
+   * @param response The final response expected; null for "OK"
+   * @return *int8_t* The one-based position of the command, 0 if the batch is
+   * full
+   */
+  int8_t add(GsmConstStr cmd, uint32_t timeout_ms = 1000L,
+             GsmConstStr response = nullptr) {
+    return add(cmd, nullptr, nullptr, timeout_ms, response);
+  }
+
+  /**
+   * @brief Add a command with an argument from RAM to the batch
+   *
+   * @param cmd The command, without the leading "AT"
+   * @param arg The text to send after the command
+   * @param tail The text to send after the argument
+   * @param timeout_ms The time to wait for the response
+   * @param response The final response expected; null for "OK"
+   * @return *int8_t* The one-based position of the command, 0 if the batch is
+   * full
+   */
+  int8_t add(GsmConstStr cmd, const char* arg, GsmConstStr tail,
+             uint32_t timeout_ms = 1000L, GsmConstStr response = nullptr) {
+    if (_count >= _capacity) { return 0; }
+    TinyGsmBatchCommand& c = _commands[_count];
+    c.cmd                  = cmd;
+    c.arg                  = arg;
+    c.tail                 = tail;
+    c.response             = response;
+    c.timeout_ms           = timeout_ms;
+    c.result               = -1;
+    return ++_count;
+  }
+
+  /**
+   * @brief Remove all of the commands from the batch
+   */
+  void clear() {
+    _count = 0;
+  }
+
+  /**
+   * @brief The number of commands in the batch
+   */
+  uint8_t count() const {
+    return _count;
+  }
+
+  /**
+   * @brief The result of a (one-based) command; see
+   * TinyGsmBatchCommand::result
+   */
+  int8_t result(uint8_t n) const {
+    return n && n <= _count ? _commands[n - 1].result : -1;
+  }
+
+  /**
+   * @brief Whether the batch stops at the first command that fails
+   */
+  bool stopOnError() const {
+    return _stop_on_error;
+  }
+
+  TinyGsmBatchCommand& operator[](uint8_t i) {
+    return _commands[i];
+  }
+
+  /**
+   * @brief The number of characters a (zero-based) command takes up on the
+   * command line
+   */
+  size_t length(uint8_t i) const {
+    const TinyGsmBatchCommand& c = _commands[i];
+    return (c.cmd ? TINY_GSM_PGM_LEN(c.cmd) : 0) + (c.arg ? strlen(c.arg) : 0) +
+        (c.tail ? TINY_GSM_PGM_LEN(c.tail) : 0);
+  }
+
+  /**
+   * @brief Whether a (zero-based) command can share a command line with the
+   * commands around it; only commands that just answer "OK" can.
+   */
+  bool chainable(uint8_t i) const {
+    return _commands[i].response == nullptr;
+  }
+
+ protected:
+  TinyGsmCommandBatch(TinyGsmBatchCommand* commands, uint8_t capacity,
+                      bool stop_on_error)
+      : _commands(commands),
+        _capacity(capacity),
+        _count(0),
+        _stop_on_error(stop_on_error) {}
+
+  // a copy would still point at the original's commands
+  TinyGsmCommandBatch(const TinyGsmCommandBatch&)            = delete;
+  TinyGsmCommandBatch& operator=(const TinyGsmCommandBatch&) = delete;
+
+ private:
+  TinyGsmBatchCommand* _commands;       ///< The commands, in order
+  uint8_t              _capacity;       ///< The number of commands available
+  uint8_t              _count;          ///< The number of commands in use
+  bool                 _stop_on_error;  ///< Stop at the first failure
+};
+
+/**
+ * @brief A TinyGsmCommandBatch with room for N commands
+ *
+ * @tparam N The maximum number of commands
+ */
+template <uint8_t N>
+class TinyGsmBatch : public TinyGsmCommandBatch {
+ public:
+  /**
+   * @param stop_on_error True to skip the rest of the batch once a command
+   * fails; false to run every command whatever the results.
+   */
+  explicit TinyGsmBatch(bool stop_on_error = true)
+      : TinyGsmCommandBatch(_commands, N, stop_on_error) {}
+
+ private:
+  TinyGsmBatchCommand _commands[N];
+};
+
+#endif  // SRC_TINYGSMBATCH_H_
@@ -0,0 +1,186 @@
+/**
+ * @file       TinyGsmBufferedStream.h
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ */
+
+#ifndef SRC_TINYGSMBUFFEREDSTREAM_H_
+#define SRC_TINYGSMBUFFEREDSTREAM_H_
+
+#include "TinyGsmCommon.h"
+
+/**
+ * @brief A thin wrapper around the stream connected to the modem that lets
+ * the response parser pull in received characters a block at a time.
+ *
+ * fill() moves whatever the underlying stream has ready into a small block
+ * buffer with a single readBytes call.  Everything read through this stream
+ * comes out of the block first and then from the underlying stream, so any
+ * characters the parser doesn't get to are still there, in order, for
+ * whatever reads the stream next.
+ *
+ * Writes and setTimeout() go straight through to the underlying stream.
+ *
+ * With TINY_GSM_STATS defined, the characters going each way are counted.
+ *
+ * @note Once the modem has been created, don't read from the underlying
+ * stream directly; there may be characters waiting in the block.
+ *
+ * @tparam N The size of the block, in characters
+ */
+template <size_t N>
+class TinyGsmBufferedStream final : public Stream {
+ public:
+  explicit TinyGsmBufferedStream(Stream& stream)
+      : _stream(stream), _pos(0), _len(0) {}
+
+  /**
+   * @brief Refill the block from the underlying stream, if it's empty.
+   *
+   * @return *size_t* The number of characters now waiting in the block
+   */
+  size_t fill() {
+    if (_pos < _len) { return _len - _pos; }
+    _pos      = 0;
+    _len      = 0;
+    int ready = _stream.available();
+    if (ready > 0) {
+      _len = _stream.readBytes(reinterpret_cast<char*>(_block),
+                               TinyGsmMin(static_cast<size_t>(ready), N));
+#ifdef TINY_GSM_STATS
+      _received += _len;
+#endif
+    }
+    return _len;
+  }
+
+  /**
+   * @brief The number of characters waiting in the block
+   */
+  size_t buffered() const {
+    return _len - _pos;
+  }
+
+  int available() override {
+    return (_len - _pos) + _stream.available();
+  }
+
+  int read() override {
+    if (_pos < _len) { return _block[_pos++]; }
+#ifdef TINY_GSM_STATS
+    int c = _stream.read();
+    if (c >= 0) { _received++; }
+    return c;
+#else
+    return _stream.read();
+#endif
+  }
+
+  /**
+   * @brief Read characters into a buffer
+   *
+   * Whatever is in the block is copied out in one go, and the characters the
+   * underlying stream already has ready are read without the per-character
+   * timeout checks of Stream::readBytes; only the rest is waited for.
+   */
+  size_t readBytes(char* buffer, size_t length) {
+    size_t n = TinyGsmMin(length, _len - _pos);
+    memcpy(buffer, _block + _pos, n);
+    _pos += n;
+    int ready = n < length ? _stream.available() : 0;
+    for (; ready > 0 && n < length; ready--) {
+      int c = _stream.read();
+      if (c < 0) { break; }
+      buffer[n++] = static_cast<char>(c);
+#ifdef TINY_GSM_STATS
+      _received++;
+#endif
+    }
+    if (n < length) { n += Stream::readBytes(buffer + n, length - n); }
+    return n;
+  }
+  size_t readBytes(uint8_t* buffer, size_t length) {
+    return readBytes(reinterpret_cast<char*>(buffer), length);
+  }
+
+  int peek() override {
+    if (_pos < _len) { return _block[_pos]; }
+    return _stream.peek();
+  }
+
+  size_t write(uint8_t c) override {
+    return count(_stream.write(c));
+  }
+
+  size_t write(const uint8_t* buffer, size_t size) override {
+    return count(_stream.write(buffer, size));
+  }
+  using Print::write;
+
+  void flush() override {
+    _stream.flush();
+  }
+
+  /**
+   * @brief Set the time to wait for characters, both for this stream and for
+   * the underlying one; Stream::setTimeout isn't virtual, so it's hidden
+   * rather than overridden
+   */
+  void setTimeout(unsigned long timeout) {
+    Stream::setTimeout(timeout);
+    _stream.setTimeout(timeout);
+  }
+
+#ifdef TINY_GSM_STATS
+  /**
+   * @brief The number of characters read from the underlying stream
+   */
+  uint32_t received() const {
+    return _received;
+  }
+
+  /**
+   * @brief The number of characters written to the underlying stream
+   */
+  uint32_t sent() const {
+    return _sent;
+  }
+
+  /**
+   * @brief Start counting from zero again
+   */
+  void resetCounts() {
+    _received = 0;
+    _sent     = 0;
+  }
+#endif
+
+ private:
+  size_t count(size_t written) {
+#ifdef TINY_GSM_STATS
+    _sent += written;
+#endif
+    return written;
+  }
+
+  Stream& _stream;    ///< The stream connected to the modem
+  uint8_t _block[N];  ///< Characters read ahead from the stream
+  size_t  _pos;       ///< The next character to hand out from the block
+  size_t  _len;       ///< The number of characters in the block
+#ifdef TINY_GSM_STATS
+  uint32_t _received = 0;  ///< Characters read from the stream
+  uint32_t _sent     = 0;  ///< Characters written to the stream
+#endif
+};
+
+#ifndef TINY_GSM_STREAM_BLOCK
+// The number of characters read from the modem's stream in one go while
+// waiting for a response
+#define TINY_GSM_STREAM_BLOCK 32
+#endif
+
+typedef TinyGsmBufferedStream<TINY_GSM_STREAM_BLOCK> TinyGsmStream;
+
+#endif  // SRC_TINYGSMBUFFEREDSTREAM_H_
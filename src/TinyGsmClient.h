@@ -143,4 +143,8 @@ typedef TinyGsmA7672X::GsmClientSecureA7672X TinyGsmClientSecure;
 #error "Please define GSM modem model"
 #endif
 
+#ifdef TINY_GSM_MODEM_HAS_UDP
+typedef GsmUDP<TinyGsm, TinyGsmClient> TinyGsmUDP;
+#endif
+
 #endif  // SRC_TINYGSMCLIENT_H_
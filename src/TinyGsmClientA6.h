@@ -10,10 +10,6 @@
 #define SRC_TINYGSMCLIENTA6_H_
 #pragma message("TinyGSM:  TinyGsmClientA6")
 
-#if !defined(TINY_GSM_MAX_RESPONSE_CHECKS)
-#define TINY_GSM_MAX_RESPONSE_CHECKS 5
-#endif
-
 #if !defined(TINY_GSM_RX_BUFFER)
 #define TINY_GSM_RX_BUFFER 64
 #endif
@@ -139,6 +135,7 @@ class TinyGsmA6
 
     virtual void stop(uint32_t maxWaitMs) {
       is_mid_send = false;
+      flushTx();
       TINY_GSM_YIELD();
       at->sendAT(GF("+CIPCLOSE="), mux);
       sock_connected = false;
@@ -546,38 +543,37 @@ class TinyGsmA6
   /*
    * Utilities
    */
- public:
-  bool handleURCs(String& data) {
-    if (data.endsWith(GF("+CIPRCV:"))) {
-      int8_t  mux          = streamGetIntBefore(',');
-      int16_t len_reported = streamGetIntBefore(',');
-      int16_t len          = len_reported;
-      if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && sockets[mux]) {
-        if (len > sockets[mux]->rx.free()) {
-          DBG("### Buffer overflow: ", len_reported, "->",
-              sockets[mux]->rx.free());
-          // reset the len to read to the amount free
-          len = sockets[mux]->rx.free();
-        }
-        moveCharsFromStreamToFifo(mux, len);
-      }
-      data = "";
-      DBG("### Got Data: ", len_reported, "on", mux);
-      return true;
-    } else if (data.endsWith(GF("+TCPCLOSED:"))) {
-      int8_t mux = streamGetIntBefore('\n');
-      if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && sockets[mux]) {
-        sockets[mux]->sock_connected = false;
+ protected:
+  // The unsolicited result codes sent by the module, in priority order
+  static const TinyGsmUrc<TinyGsmA6>* getURCTableImpl() {
+    static const TinyGsmUrc<TinyGsmA6> urcs[] = {
+        {GF("+CIPRCV:"), &TinyGsmA6::handleURCReceive},
+        {GF("+TCPCLOSED:"), &TinyGsmA6::handleURCClosedMux},
+        {nullptr, nullptr}};
+    TINY_GSM_CHECK_URC_TABLE(urcs);
+    return urcs;
+  }
+
+  // <mux>,<length>,<data> - the data is sent right in the URC
+  bool handleURCReceive(TinyGsmResponse&) {
+    int8_t  mux          = streamGetIntBefore(',');
+    int16_t len_reported = streamGetIntBefore(',');
+    int16_t len          = len_reported;
+    if (getURCSocket(mux)) {
+      if (len > sockets[mux]->rx.free()) {
+        DBG("### Buffer overflow: ", len_reported, "->",
+            sockets[mux]->rx.free());
+        // reset the len to read to the amount free
+        len = sockets[mux]->rx.free();
       }
-      data = "";
-      DBG("### Closed: ", mux);
-      return true;
+      moveCharsFromStreamToFifo(mux, len);
     }
-    return false;
+    DBG("### Got Data: ", len_reported, "on", mux);
+    return true;
   }
 
  public:
-  Stream& stream;
+  TinyGsmStream stream;
 
  protected:
   GsmClientA6* sockets[TINY_GSM_MUX_COUNT];
@@ -10,10 +10,6 @@
 #define SRC_TINYGSMCLIENTA7672X_H_
 #pragma message("TinyGSM:  TinyGsmClientA7672x")
 
-#if !defined(TINY_GSM_MAX_RESPONSE_CHECKS)
-#define TINY_GSM_MAX_RESPONSE_CHECKS 5
-#endif
-
 #if !defined(TINY_GSM_RX_BUFFER)
 #define TINY_GSM_RX_BUFFER 64
 #endif
@@ -33,6 +29,17 @@
 // application on the module.
 // TODO(?) Could someone who has this module test this?
 
+#ifdef TINY_GSM_READ_MAX_SIZE
+#undef TINY_GSM_READ_MAX_SIZE
+#endif
+#define TINY_GSM_READ_MAX_SIZE 1500
+// The maximum length for +CIPRXGET=2 in the manual
+#ifdef TINY_GSM_READ_MAX_SIZE_HEX
+#undef TINY_GSM_READ_MAX_SIZE_HEX
+#endif
+#define TINY_GSM_READ_MAX_SIZE_HEX 750
+// The maximum length for +CIPRXGET=3, which sends each byte as two characters
+
 #ifdef TINY_GSM_SEND_MAX_SIZE
 #undef TINY_GSM_SEND_MAX_SIZE
 #endif
@@ -887,101 +894,56 @@ class TinyGsmA7672X
   /*
    * Utilities
    */
- public:
-  bool handleURCs(String& data) {
-    if (data.endsWith(GF(AT_NL "+CIPRXGET:"))) {
-      int8_t mode = streamGetIntBefore(',');
-      if (mode == 1) {
-        int8_t mux = streamGetIntBefore('\n');
-        if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && sockets[mux]) {
-          sockets[mux]->got_data = true;
-        }
-        data = "";
-        DBG("### Got Data:", mux);
-        return true;
-      } else {
-        data += mode;
-        return false;
-      }
-    } else if (data.endsWith(GF("RECV EVENT" AT_NL))) {
-      // WHAT??? No, no, no, you can't issue a sendAT/waitResponse here!! The
-      // handle URC's function is the module-unique part of the general purpose
-      // waitResponse function.
-      // TODO: This is a problem, we can't issue a sendAT/waitResponse here.
-      // Totally sloppy QC on my part to let this through.
-      sendAT(GF("+CCHRECV?"));
-      String res = "";
-      waitResponse(2000L, res);
-      int8_t  mux = res.substring(res.lastIndexOf(',') + 1).toInt();
-      int16_t len =
-          res.substring(res.indexOf(',') + 1, res.lastIndexOf(',')).toInt();
-      if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && sockets[mux]) {
-        sockets[mux]->got_data = true;
-        if (len >= 0 && len <= 1024) { sockets[mux]->sock_available = len; }
-      }
-      data = "";
-      DBG("### Got Data:", len, "on", mux);
-      return true;
-    } else if (data.endsWith(GF("+CCHRECV: 0,0" AT_NL))) {
-      int8_t mux = data.substring(data.lastIndexOf(',') + 1).toInt();
-      if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && sockets[mux]) {
-        sockets[mux]->sock_connected = true;
-      }
-      data = "";
-      DBG("### ACK:", mux);
-      return true;
-    } else if (data.endsWith(GF("+IPCLOSE:"))) {
-      int8_t mux = streamGetIntBefore(',');
-      if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && sockets[mux]) {
-        sockets[mux]->sock_connected = false;
-      }
-      data = "";
-      streamSkipUntil('\n');
-      DBG("### TCP Closed: ", mux);
-      return true;
-    } else if (data.endsWith(GF("+CCHCLOSE:"))) {
-      int8_t mux = streamGetIntBefore(',');
-      if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && sockets[mux]) {
-        sockets[mux]->sock_connected = false;
-      }
-      data = "";
-      streamSkipUntil('\n');
-      DBG("### SSL Closed: ", mux);
-      return true;
-    } else if (data.endsWith(GF("+CCH_PEER_CLOSED:"))) {
-      int8_t mux = streamGetIntBefore('\n');
-      if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && sockets[mux]) {
-        sockets[mux]->sock_connected = false;
-      }
-      data = "";
-      DBG("### SSL Closed: ", mux);
-      return true;
-    } else if (data.endsWith(GF("*PSNWID:"))) {
-      streamSkipUntil('\n');  // Refresh network name by network
-      data = "";
-      DBG("### Network name updated.");
-      return true;
-    } else if (data.endsWith(GF("*PSUTTZ:"))) {
-      streamSkipUntil('\n');  // Refresh time and time zone by network
-      data = "";
-      DBG("### Network time and time zone updated.");
-      return true;
-    } else if (data.endsWith(GF("+CTZV:"))) {
-      streamSkipUntil('\n');  // Refresh network time zone by network
-      data = "";
-      DBG("### Network time zone updated.");
-      return true;
-    } else if (data.endsWith(GF("DST:"))) {
-      streamSkipUntil('\n');  // Refresh Network Daylight Saving Time by network
-      data = "";
-      DBG("### Daylight savings time state updated.");
-      return true;
+ protected:
+  // The unsolicited result codes sent by the module, in priority order
+  static const TinyGsmUrc<TinyGsmA7672X>* getURCTableImpl() {
+    static const TinyGsmUrc<TinyGsmA7672X> urcs[] = {
+        {GF(AT_NL "+CIPRXGET:"), &TinyGsmA7672X::handleURCDataModeMux},
+        {GF("RECV EVENT" AT_NL), &TinyGsmA7672X::handleURCRecvEvent},
+        {GF("+CCHRECV: 0,0" AT_NL), &TinyGsmA7672X::handleURCSSLAck},
+        {GF("+IPCLOSE:"), &TinyGsmA7672X::handleURCClosedMuxFirst},
+        {GF("+CCHCLOSE:"), &TinyGsmA7672X::handleURCClosedMuxFirst},
+        {GF("+CCH_PEER_CLOSED:"), &TinyGsmA7672X::handleURCClosedMux},
+        // Refresh of the network name, time, time zone, and daylight savings
+        // time state by the network
+        {GF("*PSNWID:"), &TinyGsmA7672X::handleURCSkipLine},
+        {GF("*PSUTTZ:"), &TinyGsmA7672X::handleURCSkipLine},
+        {GF("+CTZV:"), &TinyGsmA7672X::handleURCSkipLine},
+        {GF("DST:"), &TinyGsmA7672X::handleURCSkipLine},
+        {nullptr, nullptr}};
+    TINY_GSM_CHECK_URC_TABLE(urcs);
+    return urcs;
+  }
+
+  bool handleURCRecvEvent(TinyGsmResponse&) {
+    // WHAT??? No, no, no, you can't issue a sendAT/waitResponse here!! The
+    // handle URC's function is the module-unique part of the general purpose
+    // waitResponse function.
+    // TODO: This is a problem, we can't issue a sendAT/waitResponse here.
+    // Totally sloppy QC on my part to let this through.
+    sendAT(GF("+CCHRECV?"));
+    String res = "";
+    waitResponse(2000L, res);
+    int8_t  mux = res.substring(res.lastIndexOf(',') + 1).toInt();
+    int16_t len =
+        res.substring(res.indexOf(',') + 1, res.lastIndexOf(',')).toInt();
+    if (getURCSocket(mux)) {
+      flagSocket(mux);
+      if (len >= 0 && len <= 1024) { sockets[mux]->sock_available = len; }
     }
-    return false;
+    DBG("### Got Data:", len, "on", mux);
+    return true;
+  }
+
+  bool handleURCSSLAck(TinyGsmResponse& data) {
+    int8_t mux = data.toInt(data.lastIndexOf(',') + 1);
+    if (getURCSocket(mux)) { sockets[mux]->sock_connected = true; }
+    DBG("### ACK:", mux);
+    return true;
   }
 
  public:
-  Stream& stream;
+  TinyGsmStream stream;
 
  protected:
   GsmClientA7672X* sockets[TINY_GSM_MUX_COUNT];
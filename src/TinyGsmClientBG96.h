@@ -10,10 +10,6 @@
 #define SRC_TINYGSMCLIENTBG96_H_
 #pragma message("TinyGSM:  TinyGsmClientBG96")
 
-#if !defined(TINY_GSM_MAX_RESPONSE_CHECKS)
-#define TINY_GSM_MAX_RESPONSE_CHECKS 5
-#endif
-
 #if !defined(TINY_GSM_RX_BUFFER)
 #define TINY_GSM_RX_BUFFER 64
 #endif
@@ -30,6 +26,12 @@
 // supports 12 sockets (0-11); any of them can be SSL
 #define TINY_GSM_SECURE_MUX_COUNT 12
 
+#ifdef TINY_GSM_READ_MAX_SIZE
+#undef TINY_GSM_READ_MAX_SIZE
+#endif
+#define TINY_GSM_READ_MAX_SIZE 1500
+// The maximum length for +QIRD in the manual
+
 #ifdef TINY_GSM_SEND_MAX_SIZE
 #undef TINY_GSM_SEND_MAX_SIZE
 #endif
@@ -83,6 +85,7 @@
 
 #include "TinyGsmModem.tpp"
 #include "TinyGsmTCP.tpp"
+#include "TinyGsmUDP.h"
 #include "TinyGsmSSL.tpp"
 #include "TinyGsmGPRS.tpp"
 #include "TinyGsmCalling.tpp"
@@ -187,6 +190,7 @@ class TinyGsmBG96
 
     virtual void stop(uint32_t maxWaitMs) {
       is_mid_send          = false;
+      is_connecting        = false;
       uint32_t startMillis = millis();
       dumpModemBuffer(maxWaitMs);
       at->sendAT(GF("+QICLOSE="), mux);
@@ -278,12 +282,10 @@ class TinyGsmBG96
           buf += chunk;
           cnt += chunk;
           continue;
-        } /* TODO: Read directly into user buffer? */
+        }
         at->maintain();
         if (sock_available > 0) {
-          int n = at->modemRead(TinyGsmMin((uint16_t)rx.free(), sock_available),
-                                mux);
-          if (n == 0) break;
+          if (readFromModem(buf, cnt, size) == 0) break;
         } else {
           break;
         }
@@ -1060,7 +1062,39 @@ class TinyGsmBG96
     uint32_t timeout_ms = ((uint32_t)timeout_s) * 1000;
     bool     ssl        = sockets[mux]->is_secure;
 
+    if (!modemStartConnect(host, port, mux)) { return false; }
     if (ssl) {
+      if (waitResponse(timeout_ms, GF(AT_NL "+QSSLOPEN:")) != 1) {
+        return false;
+      }
+      // 20230629 -> +QSSLOPEN: <clientID>,<err>
+      // clientID is mux
+      // err must be 0
+      if (streamGetIntBefore(',') != mux) { return false; }
+    } else {
+      if (waitResponse(timeout_ms, GF(AT_NL "+QIOPEN:")) != 1) { return false; }
+
+      if (streamGetIntBefore(',') != mux) { return false; }
+    }
+    // Read status
+    return (0 == streamGetIntBefore('\n'));
+  }
+
+  // Both +QIOPEN and +QSSLOPEN are answered with OK straight away, and the
+  // result comes later as +QIOPEN: or +QSSLOPEN: <mux>,<err>
+  bool modemConnectAsyncImpl(const char* host, uint16_t port, uint8_t mux) {
+    GsmClientBG96* sock = sockets[mux];
+    sock->stop();
+    TINY_GSM_YIELD();
+    sock->rx.clear();
+    if (!modemStartConnect(host, port, mux)) { return false; }
+    sock->is_connecting = true;
+    return true;
+  }
+
+  // Sends the command to open a socket, and waits for the OK
+  bool modemStartConnect(const char* host, uint16_t port, uint8_t mux) {
+    if (sockets[mux]->is_secure) {
       // If we have a secure socket, use a static cast to get the authentication
       // mode and certificate names. This isn't really "safe" but since we've
       // already checked that the socket is a secure one, we're pretty sure of
@@ -1076,32 +1110,32 @@ class TinyGsmBG96
       // may need previous AT+QSSLCFG
       sendAT(GF("+QSSLOPEN=1,"), sslCtxIndex, ',', mux, GF(",\""), host,
              GF("\","), port, GF(",0"));
-      if (waitResponse() != 1) return false;
-
-      if (waitResponse(timeout_ms, GF(AT_NL "+QSSLOPEN:")) != 1) {
-        return false;
-      }
-      // 20230629 -> +QSSLOPEN: <clientID>,<err>
-      // clientID is mux
-      // err must be 0
-      if (streamGetIntBefore(',') != mux) { return false; }
-      // Read status
-      return (0 == streamGetIntBefore('\n'));
     } else {
       // AT+QIOPEN=1,0,"TCP","220.180.239.212",8009,0,0
       // <PDPcontextID>(1-16), <connectID>(0-11),
       // "TCP/UDP/TCP LISTENER/UDPSERVICE", "<IP_address>/<domain_name>",
       // <remote_port>,<local_port>,<access_mode>(0-2; 0=buffer)
-      sendAT(GF("+QIOPEN=1,"), mux, GF(",\""), GF("TCP"), GF("\",\""), host,
-             GF("\","), port, GF(",0,0"));
-      waitResponse();
-
-      if (waitResponse(timeout_ms, GF(AT_NL "+QIOPEN:")) != 1) { return false; }
+      bool udp = sockets[mux]->is_udp;
+      sendAT(GF("+QIOPEN=1,"), mux, GF(",\""), udp ? GF("UDP") : GF("TCP"),
+             GF("\",\""), host, GF("\","), port, ',',
+             udp ? sockets[mux]->local_port : 0, GF(",0"));
+    }
+    return waitResponse() == 1;
+  }
 
-      if (streamGetIntBefore(',') != mux) { return false; }
+  // +QIDNSGIP is answered with OK and the result comes later by URC; see
+  // handleURCSocket()
+  bool modemResolveImpl(const char* host, IPAddress& ip, uint32_t timeout_ms) {
+    dns_state = 0;
+    sendAT(GF("+QIDNSGIP=1,\""), host, '"');
+    if (waitResponse() != 1) { return false; }
+    uint32_t startMillis = millis();
+    while (dns_state == 0 && millis() - startMillis < timeout_ms) {
+      waitResponse(100, nullptr, nullptr);
     }
-    // Read status
-    return (0 == streamGetIntBefore('\n'));
+    if (dns_state != 1) { return false; }
+    ip = dns_ip;
+    return true;
   }
 
   bool modemBeginSendImpl(size_t len, uint8_t mux) {
@@ -1180,110 +1214,133 @@ class TinyGsmBG96
   }
 
   bool modemGetConnectedImpl(uint8_t mux) {
-    bool ssl = sockets[mux]->is_secure;
-    if (ssl) {
-      sendAT(GF("+QSSLSTATE="), mux);
-      // +QSSLSTATE:<clientID>,"SSLClient",<IP_address>,<remote_port>,<local_port>,<socket_state>,<pdpctxID>,<serverID>,<access_mode>,<AT_port>,<sslctxID>)
+    if (sockets[mux] && sockets[mux]->is_secure) {
+      return modemGetSecureConnected(mux);
+    }
+    if (!refreshAllSockets()) { return false; }
+    return sockets[mux] && sockets[mux]->sock_connected;
+  }
 
-      if (waitResponse(GF("+QSSLSTATE:")) != 1) {
-        waitResponse();  // just returns "OK" if the sock is closed
-        return false;
+  bool refreshAllSocketsImpl() {
+    // Every TCP/UDP connection that's open is listed, one line each:
+    // +QISTATE: 0,"TCP","151.139.237.11",80,5087,4,1,0,0,"uart1"
+    sendAT(GF("+QISTATE?"));
+    TinyGsmMuxMask listed = 0;
+    int8_t         res;
+    while ((res = waitResponse(GF("+QISTATE:"), GFP(GSM_OK),
+                               GFP(GSM_ERROR))) == 1) {
+      int8_t muxNo = streamGetIntBefore(',');
+      streamSkipUntil(',');                    // Skip socket type
+      streamSkipUntil(',');                    // Skip remote ip
+      streamSkipUntil(',');                    // Skip remote port
+      streamSkipUntil(',');                    // Skip local port
+      int8_t state = streamGetIntBefore(',');  // socket state
+      streamSkipUntil('\n');
+      if (muxNo < 0 || muxNo >= TINY_GSM_MUX_COUNT) { continue; }
+      listed |= static_cast<TinyGsmMuxMask>(1U << muxNo);
+      // 0 Initial, 1 Opening, 2 Connected, 3 Listening, 4 Closing
+      GsmClientBG96* sock = sockets[muxNo];
+      if (sock && !sock->is_secure) { sock->sock_connected = 2 == state; }
+    }
+    if (res != 2) { return false; }
+    for (int muxNo = 0; muxNo < TINY_GSM_MUX_COUNT; muxNo++) {
+      GsmClientBG96* sock = sockets[muxNo];
+      if (!sock) { continue; }
+      if (sock->is_secure) {
+        // SSL connections have a list of their own, which can only be asked
+        // about one at a time
+        sock->sock_connected = modemGetSecureConnected(muxNo);
+      } else if (!(listed >> muxNo & 1)) {
+        sock->sock_connected = false;
       }
+    }
+    return true;
+  }
 
-      streamSkipUntil(',');  // Skip clientID
-      // TODO: Verify mux
-      streamSkipUntil(',');                  // Skip "SSLClient"
-      streamSkipUntil(',');                  // Skip remote ip
-      streamSkipUntil(',');                  // Skip remote port
-      streamSkipUntil(',');                  // Skip local port
-      int8_t res = streamGetIntBefore(',');  // socket state
-
-      waitResponse();
-
-      // 0 Initial, 1 Opening, 2 Connected, 3 Listening, 4 Closing
-      return 2 == res;
-    } else {
-      sendAT(GF("+QISTATE=1,"), mux);
-      // +QISTATE: 0,"TCP","151.139.237.11",80,5087,4,1,0,0,"uart1"
+  bool modemGetSecureConnected(uint8_t mux) {
+    sendAT(GF("+QSSLSTATE="), mux);
+    // +QSSLSTATE:<clientID>,"SSLClient",<IP_address>,<remote_port>,<local_port>,<socket_state>,<pdpctxID>,<serverID>,<access_mode>,<AT_port>,<sslctxID>)
 
-      if (waitResponse(GF("+QISTATE:")) != 1) {
-        waitResponse();  // just returns "OK" if the sock is closed
-        return false;
-      }
+    if (waitResponse(GF("+QSSLSTATE:")) != 1) {
+      waitResponse();  // just returns "OK" if the sock is closed
+      return false;
+    }
 
-      streamSkipUntil(',');                  // Skip mux
-      streamSkipUntil(',');                  // Skip socket type
-      streamSkipUntil(',');                  // Skip remote ip
-      streamSkipUntil(',');                  // Skip remote port
-      streamSkipUntil(',');                  // Skip local port
-      int8_t res = streamGetIntBefore(',');  // socket state
+    streamSkipUntil(',');  // Skip clientID
+    // TODO: Verify mux
+    streamSkipUntil(',');                  // Skip "SSLClient"
+    streamSkipUntil(',');                  // Skip remote ip
+    streamSkipUntil(',');                  // Skip remote port
+    streamSkipUntil(',');                  // Skip local port
+    int8_t res = streamGetIntBefore(',');  // socket state
 
-      waitResponse();
+    waitResponse();
 
-      // 0 Initial, 1 Opening, 2 Connected, 3 Listening, 4 Closing
-      return 2 == res;
-    }
+    // 0 Initial, 1 Opening, 2 Connected, 3 Listening, 4 Closing
+    return 2 == res;
   }
 
   /*
    * Utilities
    */
- public:
-  bool handleURCs(String& data) {
-    if (data.endsWith(GF(AT_NL "+QIURC:"))) {
-      streamSkipUntil('\"');
-      String urc = stream.readStringUntil('\"');
-      streamSkipUntil(',');
-      if (urc == "recv") {
-        int8_t mux = streamGetIntBefore('\n');
-        DBG("### URC RECV:", mux);
-        if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && sockets[mux]) {
-          sockets[mux]->got_data = true;
-        }
-      } else if (urc == "closed") {
-        int8_t mux = streamGetIntBefore('\n');
-        DBG("### URC CLOSE:", mux);
-        if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && sockets[mux]) {
-          sockets[mux]->sock_connected = false;
-        }
+ protected:
+  // The unsolicited result codes sent by the module, in priority order
+  static const TinyGsmUrc<TinyGsmBG96>* getURCTableImpl() {
+    static const TinyGsmUrc<TinyGsmBG96> urcs[] = {
+        {GF(AT_NL "+QIURC:"), &TinyGsmBG96::handleURCSocket},
+        {GF(AT_NL "+QSSLURC:"), &TinyGsmBG96::handleURCSocket},
+        {GF("+QIOPEN:"), &TinyGsmBG96::handleURCConnectMuxResult},
+        {GF("+QSSLOPEN:"), &TinyGsmBG96::handleURCConnectMuxResult},
+        {nullptr, nullptr}};
+    TINY_GSM_CHECK_URC_TABLE(urcs);
+    return urcs;
+  }
+
+  // "<type>",<mux> - for both TCP and SSL sockets
+  bool handleURCSocket(TinyGsmResponse& data) {
+    // the two URCs differ in the character before the colon
+    bool ssl = data.endsWith(GF("LURC:"));
+    streamSkipUntil('\"');
+    String urc = stream.readStringUntil('\"');
+    streamSkipUntil(',');
+    if (urc == "recv") {
+      int8_t mux = streamGetIntBefore('\n');
+      if (ssl) {
+        DBG("### URC SSL RECV:", mux);
+        // We have no way of knowing how much data actually came in, so
+        // we set the value to 1500, the maximum transmission unit for TCP.
+        if (getURCSocket(mux)) { sockets[mux]->sock_available = 1500; }
       } else {
-        streamSkipUntil('\n');
+        DBG("### URC RECV:", mux);
+        if (getURCSocket(mux)) { flagSocket(mux); }
       }
-      data = "";
-      return true;
-    }
-    if (data.endsWith(GF(AT_NL "+QSSLURC:"))) {
-      streamSkipUntil('\"');
-      String urc = stream.readStringUntil('\"');
-      streamSkipUntil(',');
-      if (urc == "recv") {
-        int8_t mux = streamGetIntBefore('\n');
-        DBG("### URC SSL RECV:", mux);
-        if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && sockets[mux]) {
-          // We have no way of knowing how much data actually came in, so
-          // we set the value to 1500, the maximum transmission unit for TCP.
-          sockets[mux]->sock_available = 1500;
+    } else if (urc == "closed") {
+      closeURCSocket(streamGetIntBefore('\n'));
+    } else if (urc == "dnsgip") {
+      // "dnsgip",<err>,<count>,<ttl> and then "dnsgip","<ip>" for each address
+      String res = stream.readStringUntil('\n');
+      if (res.startsWith("\"")) {
+        if (dns_state == 0 &&
+            dns_ip.fromString(res.substring(1, res.indexOf('"', 1)))) {
+          dns_state = 1;
         }
-      } else if (urc == "closed") {
-        int8_t mux = streamGetIntBefore('\n');
-        DBG("### URC CLOSE:", mux);
-        if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && sockets[mux]) {
-          sockets[mux]->sock_connected = false;
-        }
-      } else {
-        streamSkipUntil('\n');
+      } else if (res.toInt() != 0 || res.substring(res.indexOf(',') + 1)
+                                             .toInt() == 0) {
+        dns_state = -1;
       }
-      data = "";
-      return true;
+    } else {
+      streamSkipUntil('\n');
     }
-    return false;
+    return true;
   }
 
  public:
-  Stream& stream;
+  TinyGsmStream stream;
 
  protected:
   GsmClientBG96* sockets[TINY_GSM_MUX_COUNT];
+  IPAddress      dns_ip;         // the first address given for a lookup
+  int8_t         dns_state = 0;  // 0 while looking up, 1 found, -1 failed
 };
 
 #endif  // SRC_TINYGSMCLIENTBG96_H_
@@ -32,6 +32,7 @@
 
 #include "TinyGsmClientEspressif.h"
 #include "TinyGsmTCP.tpp"
+#include "TinyGsmUDP.h"
 #include "TinyGsmSSL.tpp"
 #include "TinyGsmTime.tpp"
 #include "TinyGsmNTP.tpp"
@@ -335,10 +336,11 @@ class TinyGsmESP32
   void maintainImpl() {
     // Keep listening for modem URC's and proactively iterate through
     // sockets asking if any data is available
-    bool check_socks = false;
-    for (int mux = 0; mux < TINY_GSM_MUX_COUNT; mux++) {
+    bool           check_socks = false;
+    TinyGsmMuxMask flagged     = takeFlaggedSockets();
+    for (int mux = 0; flagged; mux++, flagged >>= 1) {
       GsmClientESP32* sock = sockets[mux];
-      if (sock && sock->got_data) {
+      if ((flagged & 1) && sock && sock->got_data) {
         sock->got_data = false;
         if (sock->sock_available == 0) {
           // NOTE: Only check the socket if says it got new data by the amount
@@ -958,14 +960,25 @@ class TinyGsmESP32
       }
     }
 
-    // Make the connection
-    sendAT(GF("+CIPSTART="), requested_mux, ',',
-           ssl ? GF("\"SSL") : GF("\"TCP"), GF("\",\""), host, GF("\","), port
+    // Make the connection; a UDP link takes its local port where a TCP link
+    // takes the keep alive time
+    uint16_t local_port = sockets[requested_mux]->local_port;
+    if (!sockets[requested_mux]->is_udp) {
+      sendAT(GF("+CIPSTART="), requested_mux, ',',
+             ssl ? GF("\"SSL") : GF("\"TCP"), GF("\",\""), host, GF("\","),
+             port
 #if defined(TINY_GSM_TCP_KEEP_ALIVE)
-           ,
-           ',', TINY_GSM_TCP_KEEP_ALIVE
+             ,
+             ',', TINY_GSM_TCP_KEEP_ALIVE
 #endif
-    );
+      );
+    } else if (!local_port) {
+      sendAT(GF("+CIPSTART="), requested_mux, GF(",\"UDP\",\""), host,
+             GF("\","), port);
+    } else {
+      sendAT(GF("+CIPSTART="), requested_mux, GF(",\"UDP\",\""), host,
+             GF("\","), port, ',', local_port);
+    }
 
     String data;
     int8_t rsp = waitResponse(timeout_ms, data, GFP(GSM_OK), GFP(GSM_ERROR),
@@ -1029,8 +1042,15 @@ class TinyGsmESP32
   }
 
   bool modemGetConnectedImpl(uint8_t mux) {
+    if (!refreshAllSockets()) { return false; }
+    return sockets[mux] && sockets[mux]->sock_connected;
+  }
+
+  bool refreshAllSocketsImpl() {
+    // Every open link is listed; any that isn't is closed
     sendAT(GF("+CIPSTATE?"));
     bool verified_connections[TINY_GSM_MUX_COUNT] = {0, 0, 0, 0, 0};
+    bool listed                                   = true;
     for (int muxNo = 0; muxNo < TINY_GSM_MUX_COUNT; muxNo++) {
       uint8_t has_status = waitResponse(GF("+CIPSTATE:"), GFP(GSM_OK),
                                         GFP(GSM_ERROR));
@@ -1043,6 +1063,7 @@ class TinyGsmESP32
         streamSkipUntil('\n');  // Skip client/server type
         verified_connections[returned_mux] = 1;
       } else {
+        listed = has_status == 2;
         break;
       };  // once we get to the ok or error, stop
     }
@@ -1051,80 +1072,62 @@ class TinyGsmESP32
         sockets[muxNo]->sock_connected = verified_connections[muxNo];
       }
     }
-    return verified_connections[mux];
+    return listed;
   }
 
   /*
    * Utilities
    */
- public:
-  bool handleURCs(String& data) {
-    if (data.endsWith(GF(AT_NL "+IPD,"))) {
-      int8_t   mux = streamGetIntBefore(',');
-      uint16_t len = streamGetIntBefore('\n');
-      if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && sockets[mux]) {
-        sockets[mux]->got_data = true;
-        // TODO: I'm not sure if each +IPD URC reports the amount newly received
-        // or the total now in the buffer. It appears to be the latter.
-        // sockets[mux]->sock_available = sockets[mux]->sock_available + len;
-        sockets[mux]->sock_available = len;
-      }
-      data = "";
-      DBG("### Got Data:", len, "on", mux);
-      return true;
-    } else if (data.endsWith(GF("CLOSED"))) {
-      int8_t muxStart = TinyGsmMax(0,
-                                   data.lastIndexOf(AT_NL, data.length() - 8));
-      int8_t coma     = data.indexOf(',', muxStart);
-      int8_t mux      = data.substring(muxStart, coma).toInt();
-      if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && sockets[mux]) {
-        sockets[mux]->sock_connected = false;
-      }
-      streamSkipUntil('\n');  // throw away the new line
-      data = "";
-      DBG("### Closed: ", mux);
-      return true;
-    } else if (data.endsWith(GF("ERR CODE:"))) {
+ protected:
+  // The unsolicited result codes sent by the module, in priority order
+  static const TinyGsmUrc<TinyGsmESP32>* getURCTableImpl() {
+    static const TinyGsmUrc<TinyGsmESP32> urcs[] = {
+        {GF(AT_NL "+IPD,"), &TinyGsmESP32::handleURCDataMuxLenNotice},
+        {GF("CLOSED"), &TinyGsmESP32::handleURCClosed},
+        {GF("ERR CODE:"), &TinyGsmESP32::handleURCErrorCode},
+        // Refresh time and time zone by network
+        {GF("+TIME_UPDATED"), &TinyGsmESP32::handleURCSkipLine},
+        // Status notices that don't need any action
+        {GF("busy p..."), &TinyGsmESP32::handleURCSkipLine},
+        {GF(AT_NL "ready" AT_NL), &TinyGsmESP32::handleURCSkipLine},
+        // WIFI GOT IP; WIFI GOT IPv6 LL; WIFI GOT IPv6 GL
+        {GF("WIFI GOT IP"), &TinyGsmESP32::handleURCSkipLine},
+        {GF("WIFI CONNECTED"), &TinyGsmESP32::handleURCSkipLine},
+        {GF("WIFI DISCONNECT"), &TinyGsmESP32::handleURCSkipLine},
+        {nullptr, nullptr}};
+    TINY_GSM_CHECK_URC_TABLE(urcs);
+    return urcs;
+  }
+
+  // <mux>,<length> - in passive receive mode, only the length is sent
+  bool handleURCDataMuxLenNotice(TinyGsmResponse&) {
+    int8_t   mux = streamGetIntBefore(',');
+    uint16_t len = streamGetIntBefore('\n');
+    if (getURCSocket(mux)) {
+      flagSocket(mux);
+      // TODO: I'm not sure if each +IPD URC reports the amount newly received
+      // or the total now in the buffer. It appears to be the latter.
+      // sockets[mux]->sock_available = sockets[mux]->sock_available + len;
+      sockets[mux]->sock_available = len;
+    }
+    DBG("### Got Data:", len, "on", mux);
+    return true;
+  }
+
+  // <mux>,CLOSED
+  bool handleURCClosed(TinyGsmResponse& data) {
+    handleURCClosedInData(data);
+    streamSkipUntil('\n');  // throw away the new line
+    return true;
+  }
+
+  bool handleURCErrorCode(TinyGsmResponse&) {
 #if defined(TINY_GSM_DEBUG) && !defined(DUMP_AT_COMMANDS)
-      DBG("### ERR CODE: ", stream.readStringUntil('\n'));
+    DBG("### ERR CODE: ", stream.readStringUntil('\n'));
 #else
-      streamSkipUntil('\n');  // Read out the ERR CODE
+    streamSkipUntil('\n');  // Read out the ERR CODE
 #endif
-      data = "";
-      return true;
-    } else if (data.endsWith(GF("+TIME_UPDATED"))) {
-      streamSkipUntil('\n');  // Refresh time and time zone by network
-      data = "";
-      DBG("### Network time updated.");
-      return true;
-    } else if (data.endsWith(GF("busy p..."))) {
-      streamSkipUntil('\n');
-      data = "";
-      // DBG("### Busy, please wait");
-      return true;
-    } else if (data.endsWith(GF(AT_NL "ready" AT_NL))) {
-      streamSkipUntil('\n');
-      data = "";
-      // DBG("### Module ready!");
-      return true;
-    } else if (data.endsWith(GF("WIFI GOT IP"))) {
-      // WIFI GOT IP; WIFI GOT IPv6 LL; WIFI GOT IPv6 GL
-      streamSkipUntil('\n');
-      data = "";
-      // DBG("### Wifi got IP");
-      return true;
-    } else if (data.endsWith(GF("WIFI CONNECTED"))) {
-      streamSkipUntil('\n');
-      data = "";
-      // DBG("### Wifi connected");
-      return true;
-    } else if (data.endsWith(GF("WIFI DISCONNECT"))) {
-      streamSkipUntil('\n');
-      data = "";
-      // DBG("### Wifi disconnected");
-      return true;
-    }
-    return false;
+    return true;
   }
 
  protected:
@@ -32,6 +32,7 @@
 
 #include "TinyGsmClientEspressif.h"
 #include "TinyGsmTCP.tpp"
+#include "TinyGsmUDP.h"
 #include "TinyGsmSSL.tpp"
 #include "TinyGsmTime.tpp"
 #include "TinyGsmNTP.tpp"
@@ -125,6 +126,7 @@ class TinyGsmESP8266
 
     virtual void stop(uint32_t maxWaitMs) {
       is_mid_send = false;
+      flushTx();
       TINY_GSM_YIELD();
       at->sendAT(GF("+CIPCLOSE="), mux);
       sock_connected = false;
@@ -628,14 +630,23 @@ class TinyGsmESP8266
       }
     }
 
-    // Make the connection
-    sendAT(GF("+CIPSTART="), mux, ',', ssl ? GF("\"SSL") : GF("\"TCP"),
-           GF("\",\""), host, GF("\","), port
+    // Make the connection; a UDP link takes its local port where a TCP link
+    // takes the keep alive time
+    uint16_t local_port = sockets[mux]->local_port;
+    if (!sockets[mux]->is_udp) {
+      sendAT(GF("+CIPSTART="), mux, ',', ssl ? GF("\"SSL") : GF("\"TCP"),
+             GF("\",\""), host, GF("\","), port
 #if defined(TINY_GSM_TCP_KEEP_ALIVE)
-           ,
-           ',', TINY_GSM_TCP_KEEP_ALIVE
+             ,
+             ',', TINY_GSM_TCP_KEEP_ALIVE
 #endif
-    );
+      );
+    } else if (!local_port) {
+      sendAT(GF("+CIPSTART="), mux, GF(",\"UDP\",\""), host, GF("\","), port);
+    } else {
+      sendAT(GF("+CIPSTART="), mux, GF(",\"UDP\",\""), host, GF("\","), port,
+             ',', local_port);
+    }
 
     String data;
     int8_t rsp = waitResponse(timeout_ms, data, GFP(GSM_OK), GFP(GSM_ERROR),
@@ -672,8 +683,15 @@ class TinyGsmESP8266
   }
 
   bool modemGetConnectedImpl(uint8_t mux) {
+    if (!refreshAllSockets()) { return false; }
+    return sockets[mux] && sockets[mux]->sock_connected;
+  }
+
+  bool refreshAllSocketsImpl() {
+    // Every open link is listed; any that isn't is closed
     sendAT(GF("+CIPSTATE?"));
     bool verified_connections[TINY_GSM_MUX_COUNT] = {0, 0, 0, 0, 0};
+    bool listed                                   = true;
     for (int muxNo = 0; muxNo < TINY_GSM_MUX_COUNT; muxNo++) {
       uint8_t has_status = waitResponse(GF("+CIPSTATE:"), GFP(GSM_OK),
                                         GFP(GSM_ERROR));
@@ -686,6 +704,7 @@ class TinyGsmESP8266
         streamSkipUntil('\n');  // Skip client/server type
         verified_connections[returned_mux] = 1;
       } else {
+        listed = has_status == 2;
         break;
       };  // once we get to the ok or error, stop
     }
@@ -694,73 +713,53 @@ class TinyGsmESP8266
         sockets[muxNo]->sock_connected = verified_connections[muxNo];
       }
     }
-    return verified_connections[mux];
+    return listed;
   }
 
   /*
    * Utilities
    */
- public:
-  bool handleURCs(String& data) {
-    if (data.endsWith(GF(AT_NL "+IPD,"))) {
-      int8_t  mux          = streamGetIntBefore(',');
-      int16_t len_reported = streamGetIntBefore(':');
-      int16_t len          = len_reported;
-      if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && sockets[mux]) {
-        if (len > sockets[mux]->rx.free()) {
-          DBG("### Buffer overflow: ", len, "->", sockets[mux]->rx.free());
-          // reset the len to read to the amount free
-          len = sockets[mux]->rx.free();
-        }
-        moveCharsFromStreamToFifo(mux, len);
-        // TODO(SRGDamia1): deal with buffer overflow
-      }
-      data = "";
-      return true;
-    } else if (data.endsWith(GF("CLOSED"))) {
-      int8_t muxStart = TinyGsmMax(0,
-                                   data.lastIndexOf(AT_NL, data.length() - 8));
-      int8_t coma     = data.indexOf(',', muxStart);
-      int8_t mux      = data.substring(muxStart, coma).toInt();
-      if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && sockets[mux]) {
-        sockets[mux]->sock_connected = false;
+ protected:
+  // The unsolicited result codes sent by the module, in priority order
+  static const TinyGsmUrc<TinyGsmESP8266>* getURCTableImpl() {
+    static const TinyGsmUrc<TinyGsmESP8266> urcs[] = {
+        {GF(AT_NL "+IPD,"), &TinyGsmESP8266::handleURCReceive},
+        {GF("CLOSED"), &TinyGsmESP8266::handleURCClosed},
+        // Refresh time and time zone by network
+        {GF("+TIME_UPDATED"), &TinyGsmESP8266::handleURCSkipLine},
+        // Status notices that don't need any action
+        {GF("busy p..."), &TinyGsmESP8266::handleURCSkipLine},
+        {GF(AT_NL "ready" AT_NL), &TinyGsmESP8266::handleURCSkipLine},
+        {GF("WIFI GOT IP"), &TinyGsmESP8266::handleURCSkipLine},
+        {GF("WIFI CONNECTED"), &TinyGsmESP8266::handleURCSkipLine},
+        {GF("WIFI DISCONNECT"), &TinyGsmESP8266::handleURCSkipLine},
+        {nullptr, nullptr}};
+    TINY_GSM_CHECK_URC_TABLE(urcs);
+    return urcs;
+  }
+
+  // <mux>,<length>:<data> - the data is sent right in the URC
+  bool handleURCReceive(TinyGsmResponse&) {
+    int8_t  mux          = streamGetIntBefore(',');
+    int16_t len_reported = streamGetIntBefore(':');
+    int16_t len          = len_reported;
+    if (getURCSocket(mux)) {
+      if (len > sockets[mux]->rx.free()) {
+        DBG("### Buffer overflow: ", len, "->", sockets[mux]->rx.free());
+        // reset the len to read to the amount free
+        len = sockets[mux]->rx.free();
       }
-      streamSkipUntil('\n');  // throw away the new line
-      data = "";
-      DBG("### Closed: ", mux);
-      return true;
-    } else if (data.endsWith(GF("+TIME_UPDATED"))) {
-      streamSkipUntil('\n');  // Refresh time and time zone by network
-      data = "";
-      DBG("### Network time updated.");
-      return true;
-    } else if (data.endsWith(GF("busy p..."))) {
-      streamSkipUntil('\n');
-      data = "";
-      // DBG("### Busy, please wait");
-      return true;
-    } else if (data.endsWith(GF(AT_NL "ready" AT_NL))) {
-      streamSkipUntil('\n');
-      data = "";
-      // DBG("### Module ready!");
-      return true;
-    } else if (data.endsWith(GF("WIFI GOT IP"))) {
-      streamSkipUntil('\n');
-      data = "";
-      // DBG("### Wifi got IP");
-      return true;
-    } else if (data.endsWith(GF("WIFI CONNECTED"))) {
-      streamSkipUntil('\n');
-      data = "";
-      // DBG("### Wifi connected");
-      return true;
-    } else if (data.endsWith(GF("WIFI DISCONNECT"))) {
-      streamSkipUntil('\n');
-      data = "";
-      // DBG("### Wifi disconnected");
-      return true;
+      moveCharsFromStreamToFifo(mux, len);
+      // TODO(SRGDamia1): deal with buffer overflow
     }
-    return false;
+    return true;
+  }
+
+  // <mux>,CLOSED
+  bool handleURCClosed(TinyGsmResponse& data) {
+    handleURCClosedInData(data);
+    streamSkipUntil('\n');  // throw away the new line
+    return true;
   }
 
  protected:
@@ -32,6 +32,7 @@
 
 #include "TinyGsmClientEspressif.h"
 #include "TinyGsmTCP.tpp"
+#include "TinyGsmUDP.h"
 
 // NOTE: This module supports SSL, but we do not support any certificate
 // management for the non-OS version of the ESP8266 firmware, so we define
@@ -127,6 +128,7 @@ class TinyGsmESP8266NonOS
 
     virtual void stop(uint32_t maxWaitMs) {
       is_mid_send = false;
+      flushTx();
       TINY_GSM_YIELD();
       at->sendAT(GF("+CIPCLOSE="), mux);
       sock_connected = false;
@@ -303,13 +305,23 @@ class TinyGsmESP8266NonOS
         waitResponse();
       }
     }
-    sendAT(GF("+CIPSTART="), mux, ',', ssl ? GF("\"SSL") : GF("\"TCP"),
-           GF("\",\""), host, GF("\","), port
+    // a UDP link takes its local port where a TCP link takes the keep alive
+    // time
+    uint16_t local_port = sockets[mux]->local_port;
+    if (!sockets[mux]->is_udp) {
+      sendAT(GF("+CIPSTART="), mux, ',', ssl ? GF("\"SSL") : GF("\"TCP"),
+             GF("\",\""), host, GF("\","), port
 #if defined(TINY_GSM_TCP_KEEP_ALIVE)
-           ,
-           ',', TINY_GSM_TCP_KEEP_ALIVE
+             ,
+             ',', TINY_GSM_TCP_KEEP_ALIVE
 #endif
-    );
+      );
+    } else if (!local_port) {
+      sendAT(GF("+CIPSTART="), mux, GF(",\"UDP\",\""), host, GF("\","), port);
+    } else {
+      sendAT(GF("+CIPSTART="), mux, GF(",\"UDP\",\""), host, GF("\","), port,
+             ',', local_port);
+    }
     // TODO(?): Check mux
     int8_t rsp = waitResponse(timeout_ms, GFP(GSM_OK), GFP(GSM_ERROR),
                               GF("ALREADY CONNECT"));
@@ -371,62 +383,45 @@ class TinyGsmESP8266NonOS
   /*
    * Utilities
    */
- public:
-  bool handleURCs(String& data) {
-    if (data.endsWith(GF("+IPD,"))) {
-      int8_t  mux          = streamGetIntBefore(',');
-      int16_t len_reported = streamGetIntBefore(':');
-      int16_t len          = len_reported;
-      if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && sockets[mux]) {
-        if (len > sockets[mux]->rx.free()) {
-          DBG("### Buffer overflow: ", len, "->", sockets[mux]->rx.free());
-          // reset the len to read to the amount free
-          len = sockets[mux]->rx.free();
-        }
-        moveCharsFromStreamToFifo(mux, len);
-        // TODO(SRGDamia1): deal with buffer overflow
-      }
-      data = "";
-      return true;
-    } else if (data.endsWith(GF("CLOSED"))) {
-      int8_t muxStart = TinyGsmMax(0,
-                                   data.lastIndexOf(AT_NL, data.length() - 8));
-      int8_t coma     = data.indexOf(',', muxStart);
-      int8_t mux      = data.substring(muxStart, coma).toInt();
-      if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && sockets[mux]) {
-        sockets[mux]->sock_connected = false;
+ protected:
+  // The unsolicited result codes sent by the module, in priority order
+  static const TinyGsmUrc<TinyGsmESP8266NonOS>* getURCTableImpl() {
+    static const TinyGsmUrc<TinyGsmESP8266NonOS> urcs[] = {
+        {GF("+IPD,"), &TinyGsmESP8266NonOS::handleURCReceive},
+        {GF("CLOSED"), &TinyGsmESP8266NonOS::handleURCClosed},
+        // Status notices that don't need any action
+        {GF("busy p..."), &TinyGsmESP8266NonOS::handleURCSkipLine},
+        {GF(AT_NL "ready" AT_NL), &TinyGsmESP8266NonOS::handleURCSkipLine},
+        {GF("WIFI GOT IP"), &TinyGsmESP8266NonOS::handleURCSkipLine},
+        {GF("WIFI CONNECTED"), &TinyGsmESP8266NonOS::handleURCSkipLine},
+        {GF("WIFI DISCONNECT"), &TinyGsmESP8266NonOS::handleURCSkipLine},
+        {nullptr, nullptr}};
+    TINY_GSM_CHECK_URC_TABLE(urcs);
+    return urcs;
+  }
+
+  // <mux>,<length>:<data> - the data is sent right in the URC
+  bool handleURCReceive(TinyGsmResponse&) {
+    int8_t  mux          = streamGetIntBefore(',');
+    int16_t len_reported = streamGetIntBefore(':');
+    int16_t len          = len_reported;
+    if (getURCSocket(mux)) {
+      if (len > sockets[mux]->rx.free()) {
+        DBG("### Buffer overflow: ", len, "->", sockets[mux]->rx.free());
+        // reset the len to read to the amount free
+        len = sockets[mux]->rx.free();
       }
-      streamSkipUntil('\n');  // throw away the new line
-      data = "";
-      DBG("### Closed: ", mux);
-      return true;
-    } else if (data.endsWith(GF("busy p..."))) {
-      streamSkipUntil('\n');
-      data = "";
-      // DBG("### Busy, please wait");
-      return true;
-    } else if (data.endsWith(GF(AT_NL "ready" AT_NL))) {
-      streamSkipUntil('\n');
-      data = "";
-      // DBG("### Module ready!");
-      return true;
-    } else if (data.endsWith(GF("WIFI GOT IP"))) {
-      streamSkipUntil('\n');
-      data = "";
-      // DBG("### Wifi got IP");
-      return true;
-    } else if (data.endsWith(GF("WIFI CONNECTED"))) {
-      streamSkipUntil('\n');
-      data = "";
-      // DBG("### Wifi connected");
-      return true;
-    } else if (data.endsWith(GF("WIFI DISCONNECT"))) {
-      streamSkipUntil('\n');
-      data = "";
-      // DBG("### Wifi disconnected");
-      return true;
+      moveCharsFromStreamToFifo(mux, len);
+      // TODO(SRGDamia1): deal with buffer overflow
     }
-    return false;
+    return true;
+  }
+
+  // <mux>,CLOSED
+  bool handleURCClosed(TinyGsmResponse& data) {
+    handleURCClosedInData(data);
+    streamSkipUntil('\n');  // throw away the new line
+    return true;
   }
 
  protected:
@@ -10,10 +10,6 @@
 #define SRC_TINYGSMCLIENTESPRESSIF_H_
 #pragma message("TinyGSM:  TinyGsmClientEspressif")
 
-#if !defined(TINY_GSM_MAX_RESPONSE_CHECKS)
-#define TINY_GSM_MAX_RESPONSE_CHECKS 4
-#endif
-
 #ifdef TINY_GSM_MUX_COUNT
 #undef TINY_GSM_MUX_COUNT
 #endif
@@ -363,12 +359,7 @@ class TinyGsmEspressif : public TinyGsmModem<EspressifType>,
    * Utilities
    */
  public:
-  bool handleURCs(String& data) {
-    return thisModem().handleURCs(data);
-  }
-
- public:
-  Stream& stream;
+  TinyGsmStream stream;
 };
 
 #endif  // SRC_TINYGSMCLIENTESPRESSIF_H_
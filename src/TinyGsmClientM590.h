@@ -10,10 +10,6 @@
 #define SRC_TINYGSMCLIENTM590_H_
 #pragma message("TinyGSM:  TinyGsmClientM590")
 
-#if !defined(TINY_GSM_MAX_RESPONSE_CHECKS)
-#define TINY_GSM_MAX_RESPONSE_CHECKS 5
-#endif
-
 #if !defined(TINY_GSM_RX_BUFFER)
 #define TINY_GSM_RX_BUFFER 64
 #endif
@@ -144,6 +140,7 @@ class TinyGsmM590
 
     virtual void stop(uint32_t maxWaitMs) {
       is_mid_send = false;
+      flushTx();
       TINY_GSM_YIELD();
       at->sendAT(GF("+TCPCLOSE="), mux);
       sock_connected = false;
@@ -459,9 +456,15 @@ class TinyGsmM590
   bool modemConnectImpl(const char* host, uint16_t port, uint8_t mux,
                         int timeout_s) {
     uint32_t timeout_ms = ((uint32_t)timeout_s) * 1000;
+    // the module only connects to an address, so look the host up once
+    // instead of on each try
+    IPAddress addr;
+    String    ip = host;
+    if (!addr.fromString(host)) {
+      ip = dnsIpQuery(host, timeout_ms);
+      if (!ip.length()) { return false; }
+    }
     for (int i = 0; i < 3; i++) {  // TODO(?): no need for loop?
-      String ip = dnsIpQuery(host);
-
       sendAT(GF("+TCPSETUP="), mux, ',', ip, ',', port);
       int8_t rsp = waitResponse(timeout_ms, GF(",OK" AT_NL), GF(",FAIL" AT_NL),
                                 GF("+TCPSETUP:Error" AT_NL));
@@ -476,6 +479,10 @@ class TinyGsmM590
     return false;
   }
 
+  bool modemResolveImpl(const char* host, IPAddress& ip, uint32_t timeout_ms) {
+    return ip.fromString(dnsIpQuery(host, timeout_ms));
+  }
+
   // re-implement so we don't have an extra flush
   size_t modemSendImpl(const uint8_t* buff, size_t len, uint8_t mux) {
     // Pointer to where in the buffer we're up to
@@ -541,9 +548,9 @@ class TinyGsmM590
     return 1 == res;
   }
 
-  String dnsIpQuery(const char* host) {
+  String dnsIpQuery(const char* host, uint32_t timeout_ms = 10000L) {
     sendAT(GF("+DNS=\""), host, '"');
-    if (waitResponse(10000L, GF(AT_NL "+DNS:")) != 1) { return ""; }
+    if (waitResponse(timeout_ms, GF(AT_NL "+DNS:")) != 1) { return ""; }
     String res = stream.readStringUntil('\n');
     waitResponse(GF("+DNS:OK" AT_NL));
     res.trim();
@@ -553,38 +560,36 @@ class TinyGsmM590
   /*
    * Utilities
    */
- public:
-  bool handleURCs(String& data) {
-    if (data.endsWith(GF("+TCPRECV:"))) {
-      int8_t  mux          = streamGetIntBefore(',');
-      int16_t len_reported = streamGetIntBefore(',');
-      int16_t len          = len_reported;
-      if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && sockets[mux]) {
-        if (len > sockets[mux]->rx.free()) {
-          DBG("### Buffer overflow: ", len, "->", sockets[mux]->rx.free());
-          // reset the len to read to the amount free
-          len = sockets[mux]->rx.free();
-        }
-        moveCharsFromStreamToFifo(mux, len);
-        // TODO(SRGDamia1): deal with buffer overflow
-      }
-      data = "";
-      return true;
-    } else if (data.endsWith(GF("+TCPCLOSE:"))) {
-      int8_t mux = streamGetIntBefore(',');
-      streamSkipUntil('\n');
-      if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && sockets[mux]) {
-        sockets[mux]->sock_connected = false;
+ protected:
+  // The unsolicited result codes sent by the module, in priority order
+  static const TinyGsmUrc<TinyGsmM590>* getURCTableImpl() {
+    static const TinyGsmUrc<TinyGsmM590> urcs[] = {
+        {GF("+TCPRECV:"), &TinyGsmM590::handleURCReceive},
+        {GF("+TCPCLOSE:"), &TinyGsmM590::handleURCClosedMuxFirst},
+        {nullptr, nullptr}};
+    TINY_GSM_CHECK_URC_TABLE(urcs);
+    return urcs;
+  }
+
+  // <mux>,<length>,<data> - the data is sent right in the URC
+  bool handleURCReceive(TinyGsmResponse&) {
+    int8_t  mux          = streamGetIntBefore(',');
+    int16_t len_reported = streamGetIntBefore(',');
+    int16_t len          = len_reported;
+    if (getURCSocket(mux)) {
+      if (len > sockets[mux]->rx.free()) {
+        DBG("### Buffer overflow: ", len, "->", sockets[mux]->rx.free());
+        // reset the len to read to the amount free
+        len = sockets[mux]->rx.free();
       }
-      data = "";
-      DBG("### Closed: ", mux);
-      return true;
+      moveCharsFromStreamToFifo(mux, len);
+      // TODO(SRGDamia1): deal with buffer overflow
     }
-    return false;
+    return true;
   }
 
  public:
-  Stream& stream;
+  TinyGsmStream stream;
 
  protected:
   GsmClientM590* sockets[TINY_GSM_MUX_COUNT];
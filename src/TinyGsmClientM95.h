@@ -11,10 +11,6 @@
 #define SRC_TINYGSMCLIENTM95_H_
 #pragma message("TinyGSM:  TinyGsmClientM95")
 
-#if !defined(TINY_GSM_MAX_RESPONSE_CHECKS)
-#define TINY_GSM_MAX_RESPONSE_CHECKS 5
-#endif
-
 #if !defined(TINY_GSM_RX_BUFFER)
 #define TINY_GSM_RX_BUFFER 64
 #endif
@@ -595,41 +591,35 @@ class TinyGsmM95
   /*
    * Utilities
    */
- public:
-  bool handleURCs(String& data) {
-    if (data.endsWith(GF(AT_NL "+QIRDI:"))) {
-      streamSkipUntil(',');  // Skip the context
-      streamSkipUntil(',');  // Skip the role
-      int8_t mux = streamGetIntBefore('\n');
-      // DBG("### Got Data:", mux);
-      if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && sockets[mux]) {
-        // We have no way of knowing how much data actually came in, so
-        // we set the value to 1500, the maximum possible size.
-        sockets[mux]->sock_available = 1500;
-      }
-      data = "";
-      return true;
-    } else if (data.endsWith(GF("CLOSED" AT_NL))) {
-      int8_t nl   = data.lastIndexOf(AT_NL, data.length() - 8);
-      int8_t coma = data.indexOf(',', nl + 2);
-      int8_t mux  = data.substring(nl + 2, coma).toInt();
-      if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && sockets[mux]) {
-        sockets[mux]->sock_connected = false;
-      }
-      data = "";
-      DBG("### Closed: ", mux);
-      return true;
-    } else if (data.endsWith(GF("+QNITZ:"))) {
-      streamSkipUntil('\n');  // URC for time sync
-      data = "";
-      DBG("### Network time updated.");
-      return true;
+ protected:
+  // The unsolicited result codes sent by the module, in priority order
+  static const TinyGsmUrc<TinyGsmM95>* getURCTableImpl() {
+    static const TinyGsmUrc<TinyGsmM95> urcs[] = {
+        {GF(AT_NL "+QIRDI:"), &TinyGsmM95::handleURCReadIndication},
+        {GF("CLOSED" AT_NL), &TinyGsmM95::handleURCClosedInData},
+        // URC for time sync
+        {GF("+QNITZ:"), &TinyGsmM95::handleURCSkipLine},
+        {nullptr, nullptr}};
+    TINY_GSM_CHECK_URC_TABLE(urcs);
+    return urcs;
+  }
+
+  // <context>,<role>,<mux> - new data is waiting in the modem's buffer
+  bool handleURCReadIndication(TinyGsmResponse&) {
+    streamSkipUntil(',');  // Skip the context
+    streamSkipUntil(',');  // Skip the role
+    int8_t mux = streamGetIntBefore('\n');
+    // DBG("### Got Data:", mux);
+    if (getURCSocket(mux)) {
+      // We have no way of knowing how much data actually came in, so
+      // we set the value to 1500, the maximum possible size.
+      sockets[mux]->sock_available = 1500;
     }
-    return false;
+    return true;
   }
 
  public:
-  Stream& stream;
+  TinyGsmStream stream;
 
  protected:
   GsmClientM95* sockets[TINY_GSM_MUX_COUNT];
@@ -13,10 +13,6 @@
 #define SRC_TINYGSMCLIENTMC60_H_
 #pragma message("TinyGSM:  TinyGsmClientMC60")
 
-#if !defined(TINY_GSM_MAX_RESPONSE_CHECKS)
-#define TINY_GSM_MAX_RESPONSE_CHECKS 6
-#endif
-
 #if !defined(TINY_GSM_RX_BUFFER)
 #define TINY_GSM_RX_BUFFER 64
 #endif
@@ -577,50 +573,43 @@ class TinyGsmMC60
   /*
    * Utilities
    */
- public:
-  bool handleURCs(String& data) {
-    if (data.endsWith(GF(AT_NL "+QIRDI:"))) {  // TODO(?):
-                                               // QIRD? or QIRDI?
-      // +QIRDI: <id>,<sc>,<sid>,<num>,<len>,< tlen>
-      streamSkipUntil(',');  // Skip the context
-      streamSkipUntil(',');  // Skip the role
-      // read the connection id
-      int8_t mux = streamGetIntBefore(',');
-      // read the number of packets in the buffer
-      int8_t num_packets = streamGetIntBefore(',');
-      // read the length of the current packet
-      streamSkipUntil(
-          ',');  // Skip the length of the current package in the buffer
-      int16_t len_total =
-          streamGetIntBefore('\n');  // Total length of all packages
-      if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && sockets[mux] &&
-          num_packets >= 0 && len_total >= 0) {
-        sockets[mux]->sock_available = len_total;
-      }
-      data = "";
-      // DBG("### Got Data:", len_total, "on", mux);
-      return true;
-    } else if (data.endsWith(GF("CLOSED" AT_NL))) {
-      int8_t nl   = data.lastIndexOf(AT_NL, data.length() - 8);
-      int8_t coma = data.indexOf(',', nl + 2);
-      int8_t mux  = data.substring(nl + 2, coma).toInt();
-      if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && sockets[mux]) {
-        sockets[mux]->sock_connected = false;
-      }
-      data = "";
-      DBG("### Closed: ", mux);
-      return true;
-    } else if (data.endsWith(GF("+QNITZ:"))) {
-      streamSkipUntil('\n');  // URC for time sync
-      data = "";
-      DBG("### Network time updated.");
-      return true;
+ protected:
+  // The unsolicited result codes sent by the module, in priority order
+  static const TinyGsmUrc<TinyGsmMC60>* getURCTableImpl() {
+    static const TinyGsmUrc<TinyGsmMC60> urcs[] = {
+        // TODO(?): QIRD? or QIRDI?
+        {GF(AT_NL "+QIRDI:"), &TinyGsmMC60::handleURCReadIndication},
+        {GF("CLOSED" AT_NL), &TinyGsmMC60::handleURCClosedInData},
+        // URC for time sync
+        {GF("+QNITZ:"), &TinyGsmMC60::handleURCSkipLine},
+        {nullptr, nullptr}};
+    TINY_GSM_CHECK_URC_TABLE(urcs);
+    return urcs;
+  }
+
+  // <id>,<sc>,<sid>,<num>,<len>,<tlen> - new data is waiting in the modem's
+  // buffer
+  bool handleURCReadIndication(TinyGsmResponse&) {
+    streamSkipUntil(',');  // Skip the context
+    streamSkipUntil(',');  // Skip the role
+    // read the connection id
+    int8_t mux = streamGetIntBefore(',');
+    // read the number of packets in the buffer
+    int8_t num_packets = streamGetIntBefore(',');
+    // read the length of the current packet
+    streamSkipUntil(
+        ',');  // Skip the length of the current package in the buffer
+    int16_t len_total =
+        streamGetIntBefore('\n');  // Total length of all packages
+    if (getURCSocket(mux) && num_packets >= 0 && len_total >= 0) {
+      sockets[mux]->sock_available = len_total;
     }
-    return false;
+    // DBG("### Got Data:", len_total, "on", mux);
+    return true;
   }
 
  public:
-  Stream& stream;
+  TinyGsmStream stream;
 
  protected:
   GsmClientMC60* sockets[TINY_GSM_MUX_COUNT];
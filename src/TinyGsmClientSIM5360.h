@@ -10,10 +10,6 @@
 #define SRC_TINYGSMCLIENTSIM5360_H_
 #pragma message("TinyGSM:  TinyGsmClientSIM5360")
 
-#if !defined(TINY_GSM_MAX_RESPONSE_CHECKS)
-#define TINY_GSM_MAX_RESPONSE_CHECKS 5
-#endif
-
 #if !defined(TINY_GSM_RX_BUFFER)
 #define TINY_GSM_RX_BUFFER 64
 #endif
@@ -754,54 +750,29 @@ class TinyGsmSim5360
   /*
    * Utilities
    */
- public:
-  bool handleURCs(String& data) {
-    if (data.endsWith(GF(AT_NL "+CIPRXGET:"))) {
-      int8_t mode = streamGetIntBefore(',');
-      if (mode == 1) {
-        int8_t mux = streamGetIntBefore('\n');
-        if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && sockets[mux]) {
-          sockets[mux]->got_data = true;
-        }
-        data = "";
-        // DBG("### Got Data:", mux);
-        return true;
-      } else {
-        data += mode;
-        return false;
-      }
-    } else if (data.endsWith(GF(AT_NL "+RECEIVE:"))) {
-      int8_t  mux = streamGetIntBefore(',');
-      int16_t len = streamGetIntBefore('\n');
-      if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && sockets[mux]) {
-        sockets[mux]->got_data = true;
-        if (len >= 0 && len <= 1024) { sockets[mux]->sock_available = len; }
-      }
-      data = "";
-      // DBG("### Got Data:", len, "on", mux);
-      return true;
-    } else if (data.endsWith(GF("+IPCLOSE:"))) {
-      int8_t mux = streamGetIntBefore(',');
-      streamSkipUntil('\n');  // Skip the reason code
-      if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && sockets[mux]) {
-        sockets[mux]->sock_connected = false;
-      }
-      data = "";
-      DBG("### Closed: ", mux);
-      return true;
-    } else if (data.endsWith(GF("+CIPEVENT:"))) {
-      // Need to close all open sockets and release the network library.
-      // User will then need to reconnect.
-      DBG("### Network error!");
-      if (!isGprsConnected()) { gprsDisconnect(); }
-      data = "";
-      return true;
-    }
-    return false;
+ protected:
+  // The unsolicited result codes sent by the module, in priority order
+  static const TinyGsmUrc<TinyGsmSim5360>* getURCTableImpl() {
+    static const TinyGsmUrc<TinyGsmSim5360> urcs[] = {
+        {GF(AT_NL "+CIPRXGET:"), &TinyGsmSim5360::handleURCDataModeMux},
+        {GF(AT_NL "+RECEIVE:"), &TinyGsmSim5360::handleURCDataMuxLen},
+        {GF("+IPCLOSE:"), &TinyGsmSim5360::handleURCClosedMuxFirst},
+        {GF("+CIPEVENT:"), &TinyGsmSim5360::handleURCNetworkError},
+        {nullptr, nullptr}};
+    TINY_GSM_CHECK_URC_TABLE(urcs);
+    return urcs;
+  }
+
+  bool handleURCNetworkError(TinyGsmResponse&) {
+    // Need to close all open sockets and release the network library.
+    // User will then need to reconnect.
+    DBG("### Network error!");
+    if (!isGprsConnected()) { gprsDisconnect(); }
+    return true;
   }
 
  public:
-  Stream& stream;
+  TinyGsmStream stream;
 
  protected:
   GsmClientSim5360* sockets[TINY_GSM_MUX_COUNT];
@@ -126,7 +126,8 @@ class TinyGsmSim7000
     TINY_GSM_CLIENT_CONNECT_OVERRIDES
 
     virtual void stop(uint32_t maxWaitMs) {
-      is_mid_send = false;
+      is_mid_send   = false;
+      is_connecting = false;
       dumpModemBuffer(maxWaitMs);
       at->sendAT(GF("+CIPCLOSE="), mux);
       sock_connected = false;
@@ -380,10 +381,21 @@ class TinyGsmSim7000
     // when not using SSL, the TCP application toolkit is more stable
     sendAT(GF("+CIPSTART="), mux, ',', GF("\"TCP"), GF("\",\""), host,
            GF("\","), port);
-    return (1 ==
-            waitResponse(timeout_ms, GF("CONNECT OK" AT_NL),
-                         GF("CONNECT FAIL" AT_NL), GF("ALREADY CONNECT" AT_NL),
-                         GF("ERROR" AT_NL), GF("CLOSE OK" AT_NL)));
+    return waitConnectResult(mux, timeout_ms);
+  }
+
+  // +CIPSTART is answered with OK at once; the connection is reported later
+  // with <mux>, CONNECT OK or <mux>, CONNECT FAIL
+  bool modemConnectAsyncImpl(const char* host, uint16_t port, uint8_t mux) {
+    GsmClientSim7000* sock = sockets[mux];
+    sock->stop();
+    TINY_GSM_YIELD();
+    sock->rx.clear();
+    sendAT(GF("+CIPSTART="), mux, ',', GF("\"TCP"), GF("\",\""), host,
+           GF("\","), port);
+    if (waitResponse() != 1) { return false; }
+    sock->is_connecting = true;
+    return true;
   }
 
   bool modemBeginSendImpl(size_t len, uint8_t mux) {
@@ -449,81 +461,60 @@ class TinyGsmSim7000
   }
 
   bool modemGetConnectedImpl(uint8_t mux) {
-    sendAT(GF("+CIPSTATUS="), mux);
-    waitResponse(GF("+CIPSTATUS"));
-    int8_t res = waitResponse(GF(",\"CONNECTED\""), GF(",\"CLOSED\""),
-                              GF(",\"CLOSING\""), GF(",\"REMOTE CLOSING\""),
-                              GF(",\"INITIAL\""));
-    waitResponse();
-    return 1 == res;
+    if (!refreshAllSockets()) { return false; }
+    return sockets[mux] && sockets[mux]->sock_connected;
+  }
+
+  bool refreshAllSocketsImpl() {
+    // Without a mux, every connection is listed after the OK, one per line:
+    // C: <n>,<bearer>,<"TCP"/"UDP">,<"IP">,<"port">,<"state">
+    sendAT(GF("+CIPSTATUS"));
+    if (waitResponse() != 1) { return false; }
+    for (int line = 0; line < TINY_GSM_MUX_COUNT; line++) {
+      if (waitResponse(GF("C: ")) != 1) { return false; }
+      int8_t muxNo = streamGetIntBefore(',');
+      streamSkipUntil(',');  // Skip bearer
+      streamSkipUntil(',');  // Skip type
+      streamSkipUntil(',');  // Skip remote IP
+      streamSkipUntil(',');  // Skip remote port
+      String state = stream.readStringUntil('\n');
+      if (muxNo >= 0 && muxNo < TINY_GSM_MUX_COUNT && sockets[muxNo]) {
+        sockets[muxNo]->sock_connected = state.indexOf("\"CONNECTED\"") >= 0;
+      }
+    }
+    return true;
   }
 
   /*
    * Utilities
    */
- public:
-  bool handleURCs(String& data) {
-    if (data.endsWith(GF(AT_NL "+CIPRXGET:"))) {
-      int8_t mode = streamGetIntBefore(',');
-      if (mode == 1) {
-        int8_t mux = streamGetIntBefore('\n');
-        if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && sockets[mux]) {
-          sockets[mux]->got_data = true;
-        }
-        data = "";
-        // DBG("### Got Data:", mux);
-        return true;
-      } else {
-        data += mode;
-        return false;
-      }
-    } else if (data.endsWith(GF(AT_NL "+RECEIVE:"))) {
-      int8_t  mux = streamGetIntBefore(',');
-      int16_t len = streamGetIntBefore('\n');
-      if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && sockets[mux]) {
-        sockets[mux]->got_data = true;
-        if (len >= 0 && len <= 1024) { sockets[mux]->sock_available = len; }
-      }
-      data = "";
-      // DBG("### Got Data:", len, "on", mux);
-      return true;
-    } else if (data.endsWith(GF("CLOSED" AT_NL))) {
-      int8_t nl   = data.lastIndexOf(AT_NL, data.length() - 8);
-      int8_t coma = data.indexOf(',', nl + 2);
-      int8_t mux  = data.substring(nl + 2, coma).toInt();
-      if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && sockets[mux]) {
-        sockets[mux]->sock_connected = false;
-      }
-      data = "";
-      DBG("### Closed: ", mux);
-      return true;
-    } else if (data.endsWith(GF("*PSNWID:"))) {
-      streamSkipUntil('\n');  // Refresh network name by network
-      data = "";
-      DBG("### Network name updated.");
-      return true;
-    } else if (data.endsWith(GF("*PSUTTZ:"))) {
-      streamSkipUntil('\n');  // Refresh time and time zone by network
-      data = "";
-      DBG("### Network time and time zone updated.");
-      return true;
-    } else if (data.endsWith(GF("+CTZV:"))) {
-      streamSkipUntil('\n');  // Refresh network time zone by network
-      data = "";
-      DBG("### Network time zone updated.");
-      return true;
-    } else if (data.endsWith(GF("DST: "))) {
-      streamSkipUntil('\n');  // Refresh Network Daylight Saving Time by network
-      data = "";
-      DBG("### Daylight savings time state updated.");
-      return true;
-    } else if (data.endsWith(GF(AT_NL "SMS Ready" AT_NL))) {
-      data = "";
-      DBG("### Unexpected module reset!");
-      init();
-      return true;
-    }
-    return false;
+ protected:
+  // The unsolicited result codes sent by the module, in priority order
+  static const TinyGsmUrc<TinyGsmSim7000>* getURCTableImpl() {
+    static const TinyGsmUrc<TinyGsmSim7000> urcs[] = {
+        {GF(AT_NL "+CIPRXGET:"), &TinyGsmSim7000::handleURCDataModeMux},
+        {GF(AT_NL "+RECEIVE:"), &TinyGsmSim7000::handleURCDataMuxLen},
+        {GF("CLOSED" AT_NL), &TinyGsmSim7000::handleURCClosedInData},
+        {GF("CONNECT OK" AT_NL), &TinyGsmSim7000::handleURCConnectOkInData},
+        {GF("CONNECT FAIL" AT_NL),
+         &TinyGsmSim7000::handleURCConnectFailInData},
+        // Refresh of the network name, time, time zone, and daylight savings
+        // time state by the network
+        {GF("*PSNWID:"), &TinyGsmSim7000::handleURCSkipLine},
+        {GF("*PSUTTZ:"), &TinyGsmSim7000::handleURCSkipLine},
+        {GF("+CTZV:"), &TinyGsmSim7000::handleURCSkipLine},
+        {GF("DST: "), &TinyGsmSim7000::handleURCSkipLine},
+        {GF(AT_NL "SMS Ready" AT_NL), &TinyGsmSim7000::handleURCReset},
+        {nullptr, nullptr}};
+    TINY_GSM_CHECK_URC_TABLE(urcs);
+    return urcs;
+  }
+
+  bool handleURCReset(TinyGsmResponse& data) {
+    data = "";
+    DBG("### Unexpected module reset!");
+    init();
+    return true;
   }
 
  protected:
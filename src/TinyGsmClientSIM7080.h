@@ -62,6 +62,7 @@
 
 #include "TinyGsmClientSIM70xx.h"
 #include "TinyGsmTCP.tpp"
+#include "TinyGsmUDP.h"
 #include "TinyGsmSSL.tpp"
 #include "TinyGsmSMS.tpp"
 #include "TinyGsmGSMLocation.tpp"
@@ -267,10 +268,11 @@ class TinyGsmSim7080
   void maintainImpl() {
     // Keep listening for modem URC's and proactively iterate through
     // sockets asking if any data is available
-    bool check_socks = false;
-    for (int mux = 0; mux < TINY_GSM_MUX_COUNT; mux++) {
+    bool           check_socks = false;
+    TinyGsmMuxMask flagged     = takeFlaggedSockets();
+    for (int mux = 0; flagged; mux++, flagged >>= 1) {
       GsmClientSim7080* sock = sockets[mux];
-      if (sock && sock->got_data) {
+      if ((flagged & 1) && sock && sock->got_data) {
         sock->got_data = false;
         check_socks    = true;
       }
@@ -995,7 +997,9 @@ class TinyGsmSim7080
     //                +CAURC:
     //                "recv",<id>,<length>,<remoteIP>,<remote_port><CR><LF><data>
     // NOTE:  including the <recv_mode> fails
-    sendAT(GF("+CAOPEN="), mux, GF(",0,\"TCP\",\""), host, GF("\","), port);
+    sendAT(GF("+CAOPEN="), mux, GF(",0,\""),
+           sockets[mux]->is_udp ? GF("UDP") : GF("TCP"), GF("\",\""), host,
+           GF("\","), port);
     if (waitResponse(timeout_ms, GF(AT_NL "+CAOPEN:")) != 1) { return 0; }
     // returns OK/r/n/r/n+CAOPEN: <cid>,<result>
     // <result> 0: Success
@@ -1166,6 +1170,11 @@ class TinyGsmSim7080
   }
 
   bool modemGetConnectedImpl(uint8_t mux) {
+    if (!refreshAllSockets()) { return false; }
+    return sockets[mux] && sockets[mux]->sock_connected;
+  }
+
+  bool refreshAllSocketsImpl() {
     // NOTE:  This gets the state of all connections that have been opened
     // since the last connection
     sendAT(GF("+CASTATE?"));
@@ -1203,78 +1212,51 @@ class TinyGsmSim7080
         break;
       } else {
         // if we got an error, give up
-        break;
+        return false;
       }
       // Should be a final OK at the end.
       // If every connection was returned, catch the OK here.
       // If only a portion were returned, catch it above.
       if (muxNo == TINY_GSM_MUX_COUNT - 1) { waitResponse(); }
     }
-    return sockets[mux]->sock_connected;
+    return true;
   }
 
   /*
    * Utilities
    */
- public:
-  bool handleURCs(String& data) {
-    if (data.endsWith(GF("+CARECV:"))) {
-      int8_t  mux = streamGetIntBefore(',');
-      int16_t len = streamGetIntBefore('\n');
-      if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && sockets[mux]) {
-        sockets[mux]->got_data = true;
-        if (len >= 0 && len <= 1024) { sockets[mux]->sock_available = len; }
-      }
-      data = "";
-      DBG("### Got Data:", len, "on", mux);
-      return true;
-    } else if (data.endsWith(GF("+CADATAIND:"))) {
-      int8_t mux = streamGetIntBefore('\n');
-      if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && sockets[mux]) {
-        sockets[mux]->got_data = true;
-      }
-      data = "";
-      DBG("### Got Data:", mux);
-      return true;
-    } else if (data.endsWith(GF("+CASTATE:"))) {
-      int8_t mux   = streamGetIntBefore(',');
-      int8_t state = streamGetIntBefore('\n');
-      if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && sockets[mux]) {
-        if (state != 1) {
-          sockets[mux]->sock_connected = false;
-          DBG("### Closed: ", mux);
-        }
-      }
-      data = "";
-      return true;
-    } else if (data.endsWith(GF("*PSNWID:"))) {
-      streamSkipUntil('\n');  // Refresh network name by network
-      data = "";
-      DBG("### Network name updated.");
-      return true;
-    } else if (data.endsWith(GF("*PSUTTZ:"))) {
-      streamSkipUntil('\n');  // Refresh time and time zone by network
-      data = "";
-      DBG("### Network time and time zone updated.");
-      return true;
-    } else if (data.endsWith(GF("+CTZV:"))) {
-      streamSkipUntil('\n');  // Refresh network time zone by network
-      data = "";
-      DBG("### Network time zone updated.");
-      return true;
-    } else if (data.endsWith(GF("DST: "))) {
-      streamSkipUntil('\n');  // Refresh Network Daylight Saving Time by network
-      data = "";
-      DBG("### Daylight savings time state updated.");
-      return true;
-    } else if (data.endsWith(GF(AT_NL "SMS Ready" AT_NL))) {
-      data = "";
-      DBG("### Unexpected module reset!");
-      init();
-      data = "";
-      return true;
-    }
-    return false;
+ protected:
+  // The unsolicited result codes sent by the module, in priority order
+  static const TinyGsmUrc<TinyGsmSim7080>* getURCTableImpl() {
+    static const TinyGsmUrc<TinyGsmSim7080> urcs[] = {
+        {GF("+CARECV:"), &TinyGsmSim7080::handleURCDataMuxLen},
+        {GF("+CADATAIND:"), &TinyGsmSim7080::handleURCDataMux},
+        {GF("+CASTATE:"), &TinyGsmSim7080::handleURCState},
+        // Refresh of the network name, time, time zone, and daylight savings
+        // time state by the network
+        {GF("*PSNWID:"), &TinyGsmSim7080::handleURCSkipLine},
+        {GF("*PSUTTZ:"), &TinyGsmSim7080::handleURCSkipLine},
+        {GF("+CTZV:"), &TinyGsmSim7080::handleURCSkipLine},
+        {GF("DST: "), &TinyGsmSim7080::handleURCSkipLine},
+        {GF(AT_NL "SMS Ready" AT_NL), &TinyGsmSim7080::handleURCReset},
+        {nullptr, nullptr}};
+    TINY_GSM_CHECK_URC_TABLE(urcs);
+    return urcs;
+  }
+
+  // <mux>,<state> - any state other than 1 means the socket is closed
+  bool handleURCState(TinyGsmResponse&) {
+    int8_t mux   = streamGetIntBefore(',');
+    int8_t state = streamGetIntBefore('\n');
+    if (getURCSocket(mux) && state != 1) { closeURCSocket(mux); }
+    return true;
+  }
+
+  bool handleURCReset(TinyGsmResponse& data) {
+    data = "";
+    DBG("### Unexpected module reset!");
+    init();
+    return true;
   }
 
  protected:
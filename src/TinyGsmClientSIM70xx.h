@@ -10,9 +10,6 @@
 #define SRC_TINYGSMCLIENTSIM70XX_H_
 #pragma message("TinyGSM:  TinyGsmClientSIM70xx")
 
-#if !defined(TINY_GSM_MAX_RESPONSE_CHECKS)
-#define TINY_GSM_MAX_RESPONSE_CHECKS 5
-#endif
 #ifdef AT_NL
 #undef AT_NL
 #endif
@@ -278,88 +275,48 @@ class TinyGsmSim70xx : public TinyGsmModem<SIM70xxType>,
       return false;
     }
 
-    thisModem().streamSkipUntil(',');                // GNSS run status
-    if (thisModem().streamGetIntBefore(',') == 1) {  // fix status
-      // init variables
-      float ilat         = 0;
-      float ilon         = 0;
-      float ispeed       = 0;
-      float ialt         = 0;
-      int   ivsat        = 0;
-      int   iusat        = 0;
-      float iaccuracy    = 0;
-      int   iyear        = 0;
-      int   imonth       = 0;
-      int   iday         = 0;
-      int   ihour        = 0;
-      int   imin         = 0;
-      float secondWithSS = 0;
-
-      // UTC date & Time
-      iyear        = thisModem().streamGetIntLength(4);  // Four digit year
-      imonth       = thisModem().streamGetIntLength(2);  // Two digit month
-      iday         = thisModem().streamGetIntLength(2);  // Two digit day
-      ihour        = thisModem().streamGetIntLength(2);  // Two digit hour
-      imin         = thisModem().streamGetIntLength(2);  // Two digit minute
-      secondWithSS = thisModem().streamGetFloatBefore(
-          ',');  // 6 digit second with subseconds
-
-      ilat = thisModem().streamGetFloatBefore(',');  // Latitude
-      ilon = thisModem().streamGetFloatBefore(',');  // Longitude
-      ialt = thisModem().streamGetFloatBefore(
-          ',');  // MSL Altitude. Unit is meters
-      ispeed = thisModem().streamGetFloatBefore(
-          ',');                          // Speed Over Ground. Unit is knots.
-      thisModem().streamSkipUntil(',');  // Course Over Ground. Degrees.
-      thisModem().streamSkipUntil(',');  // Fix Mode
-      thisModem().streamSkipUntil(',');  // Reserved1
-      iaccuracy = thisModem().streamGetFloatBefore(
-          ',');                          // Horizontal Dilution Of Precision
-      thisModem().streamSkipUntil(',');  // Position Dilution Of Precision
-      thisModem().streamSkipUntil(',');  // Vertical Dilution Of Precision
-      thisModem().streamSkipUntil(',');  // Reserved2
-      ivsat = thisModem().streamGetIntBefore(',');  // GNSS Satellites in View
-      iusat = thisModem().streamGetIntBefore(',');  // GNSS Satellites Used
-      thisModem().streamSkipUntil(',');             // GLONASS Satellites Used
-      thisModem().streamSkipUntil(',');             // Reserved3
-      thisModem().streamSkipUntil(',');             // C/N0 max
-      thisModem().streamSkipUntil(',');             // HPA
-      thisModem().streamSkipUntil('\n');            // VPA
-
-      // Set pointers
-      if (lat != nullptr) *lat = ilat;
-      if (lon != nullptr) *lon = ilon;
-      if (speed != nullptr) *speed = ispeed;
-      if (alt != nullptr) *alt = ialt;
-      if (vsat != nullptr) *vsat = ivsat;
-      if (usat != nullptr) *usat = iusat;
-      if (accuracy != nullptr) *accuracy = iaccuracy;
-      if (iyear < 2000) iyear += 2000;
-      if (year != nullptr) *year = iyear;
-      if (month != nullptr) *month = imonth;
-      if (day != nullptr) *day = iday;
-      if (hour != nullptr) *hour = ihour;
-      if (minute != nullptr) *minute = imin;
-      if (second != nullptr) *second = static_cast<int>(secondWithSS);
-
+    // The whole line is read at once:
+    // 0 GNSS run status, 1 fix status, 2 UTC date & time, 3 latitude,
+    // 4 longitude, 5 MSL altitude (m), 6 speed over ground (knots),
+    // 7 course over ground (degrees), 8 fix mode, 9 reserved1,
+    // 10 HDOP, 11 PDOP, 12 VDOP, 13 reserved2, 14 GNSS satellites in view,
+    // 15 GNSS satellites used, 16 GLONASS satellites used, 17 reserved3,
+    // 18 C/N0 max, 19 HPA, 20 VPA
+    TinyGsmFields<21, 128> fields;
+    thisModem().streamGetFields(fields);
+    if (fields.toInt(1) != 1) {  // no fix, just a row of commas
       thisModem().waitResponse();
-      return true;
+      return false;
     }
 
-    thisModem().streamSkipUntil('\n');  // toss the row of commas
+    // UTC date & time, as yyyyMMddhhmmss.sss
+    int iyear = fields.toInt(2, 0, 4, 0);
+    if (iyear < 2000) iyear += 2000;
+
+    // Set pointers
+    if (lat != nullptr) *lat = fields.toFloat(3, 0);
+    if (lon != nullptr) *lon = fields.toFloat(4, 0);
+    if (alt != nullptr) *alt = fields.toFloat(5, 0);
+    if (speed != nullptr) *speed = fields.toFloat(6, 0);
+    if (accuracy != nullptr) *accuracy = fields.toFloat(10, 0);
+    if (vsat != nullptr) *vsat = fields.toInt(14, 0);
+    if (usat != nullptr) *usat = fields.toInt(15, 0);
+    if (year != nullptr) *year = iyear;
+    if (month != nullptr) *month = fields.toInt(2, 4, 2, 0);
+    if (day != nullptr) *day = fields.toInt(2, 6, 2, 0);
+    if (hour != nullptr) *hour = fields.toInt(2, 8, 2, 0);
+    if (minute != nullptr) *minute = fields.toInt(2, 10, 2, 0);
+    if (second != nullptr) *second = fields.toInt(2, 12, 2, 0);
+
     thisModem().waitResponse();
-    return false;
+    return true;
   }
 
   /*
    * Utilities
    */
-  bool handleURCs(String& data) {
-    return thisModem().handleURCs(data);
-  }
-
  public:
-  Stream& stream;
+  TinyGsmStream stream;
 };
 
 #endif  // SRC_TINYGSMCLIENTSIM70XX_H_
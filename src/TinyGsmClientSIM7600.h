@@ -10,10 +10,6 @@
 #define SRC_TINYGSMCLIENTSIM7600_H_
 #pragma message("TinyGSM:  TinyGsmClientSIM7600")
 
-#if !defined(TINY_GSM_MAX_RESPONSE_CHECKS)
-#define TINY_GSM_MAX_RESPONSE_CHECKS 5
-#endif
-
 #if !defined(TINY_GSM_RX_BUFFER)
 #define TINY_GSM_RX_BUFFER 64
 #endif
@@ -32,6 +28,17 @@
 // application on the module.
 // TODO(?) Could someone who has this module test this?
 
+#ifdef TINY_GSM_READ_MAX_SIZE
+#undef TINY_GSM_READ_MAX_SIZE
+#endif
+#define TINY_GSM_READ_MAX_SIZE 1500
+// The maximum length for +CIPRXGET=2 in the manual
+#ifdef TINY_GSM_READ_MAX_SIZE_HEX
+#undef TINY_GSM_READ_MAX_SIZE_HEX
+#endif
+#define TINY_GSM_READ_MAX_SIZE_HEX 750
+// The maximum length for +CIPRXGET=3, which sends each byte as two characters
+
 #ifdef TINY_GSM_SEND_MAX_SIZE
 #undef TINY_GSM_SEND_MAX_SIZE
 #endif
@@ -1083,6 +1090,12 @@ class TinyGsmSim7600
   }
 
   bool modemGetConnectedImpl(uint8_t mux) {
+    if (!refreshAllSockets()) { return false; }
+    if (!sockets[mux]) return false;
+    return sockets[mux]->sock_connected;
+  }
+
+  bool refreshAllSocketsImpl() {
     // TODO(SRGD): I think this only returns the TCP socket connection status,
     // not the SSL connection status
     // Read the status of all sockets at once
@@ -1091,64 +1104,40 @@ class TinyGsmSim7600
     for (int muxNo = 0; muxNo < TINY_GSM_MUX_COUNT; muxNo++) {
       // +CIPOPEN:<mux>,<State or blank...>
       String state = stream.readStringUntil('\n');
-      if (state.indexOf(',') > 0) { sockets[muxNo]->sock_connected = true; }
+      if (sockets[muxNo]) {
+        sockets[muxNo]->sock_connected = state.indexOf(',') > 0;
+      }
     }
     waitResponse();  // Should be an OK at the end
-    if (!sockets[mux]) return false;
-    return sockets[mux]->sock_connected;
+    return true;
   }
 
   /*
    * Utilities
    */
- public:
-  bool handleURCs(String& data) {
-    if (data.endsWith(GF(AT_NL "+CIPRXGET:"))) {
-      int8_t mode = streamGetIntBefore(',');
-      if (mode == 1) {
-        int8_t mux = streamGetIntBefore('\n');
-        if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && sockets[mux]) {
-          sockets[mux]->got_data = true;
-        }
-        data = "";
-        // DBG("### Got Data:", mux);
-        return true;
-      } else {
-        data += mode;
-        return false;
-      }
-    } else if (data.endsWith(GF(AT_NL "+RECEIVE:"))) {
-      int8_t  mux = streamGetIntBefore(',');
-      int16_t len = streamGetIntBefore('\n');
-      if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && sockets[mux]) {
-        sockets[mux]->got_data = true;
-        if (len >= 0 && len <= 1024) { sockets[mux]->sock_available = len; }
-      }
-      data = "";
-      // DBG("### Got Data:", len, "on", mux);
-      return true;
-    } else if (data.endsWith(GF("+IPCLOSE:"))) {
-      int8_t mux = streamGetIntBefore(',');
-      streamSkipUntil('\n');  // Skip the reason code
-      if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && sockets[mux]) {
-        sockets[mux]->sock_connected = false;
-      }
-      data = "";
-      DBG("### Closed: ", mux);
-      return true;
-    } else if (data.endsWith(GF("+CIPEVENT:"))) {
-      // Need to close all open sockets and release the network library.
-      // User will then need to reconnect.
-      DBG("### Network error!");
-      if (!isGprsConnected()) { gprsDisconnect(); }
-      data = "";
-      return true;
-    }
-    return false;
+ protected:
+  // The unsolicited result codes sent by the module, in priority order
+  static const TinyGsmUrc<TinyGsmSim7600>* getURCTableImpl() {
+    static const TinyGsmUrc<TinyGsmSim7600> urcs[] = {
+        {GF(AT_NL "+CIPRXGET:"), &TinyGsmSim7600::handleURCDataModeMux},
+        {GF(AT_NL "+RECEIVE:"), &TinyGsmSim7600::handleURCDataMuxLen},
+        {GF("+IPCLOSE:"), &TinyGsmSim7600::handleURCClosedMuxFirst},
+        {GF("+CIPEVENT:"), &TinyGsmSim7600::handleURCNetworkError},
+        {nullptr, nullptr}};
+    TINY_GSM_CHECK_URC_TABLE(urcs);
+    return urcs;
+  }
+
+  bool handleURCNetworkError(TinyGsmResponse&) {
+    // Need to close all open sockets and release the network library.
+    // User will then need to reconnect.
+    DBG("### Network error!");
+    if (!isGprsConnected()) { gprsDisconnect(); }
+    return true;
   }
 
  public:
-  Stream& stream;
+  TinyGsmStream stream;
 
  protected:
   GsmClientSim7600* sockets[TINY_GSM_MUX_COUNT];
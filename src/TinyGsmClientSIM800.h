@@ -10,10 +10,6 @@
 #define SRC_TINYGSMCLIENTSIM800_H_
 #pragma message("TinyGSM:  TinyGsmClientSIM800")
 
-#if !defined(TINY_GSM_MAX_RESPONSE_CHECKS)
-#define TINY_GSM_MAX_RESPONSE_CHECKS 5
-#endif
-
 #if !defined(TINY_GSM_RX_BUFFER)
 #define TINY_GSM_RX_BUFFER 64
 #endif
@@ -27,6 +23,14 @@
 #endif
 #define TINY_GSM_SECURE_MUX_COUNT 5
 
+// The number of connections the module itself has, all of which are listed by
+// +CIPSTATUS; only the first TINY_GSM_MUX_COUNT are used
+#if defined(TINY_GSM_MODEM_SIM900)
+#define TINY_GSM_SIM800_CONNECTIONS 8
+#else
+#define TINY_GSM_SIM800_CONNECTIONS 6
+#endif
+
 #ifdef TINY_GSM_NO_MODEM_BUFFER
 #undef TINY_GSM_NO_MODEM_BUFFER
 #endif
@@ -43,6 +47,17 @@
 #define TINY_GSM_MUX_STATIC
 #endif
 
+#ifdef TINY_GSM_READ_MAX_SIZE
+#undef TINY_GSM_READ_MAX_SIZE
+#endif
+#define TINY_GSM_READ_MAX_SIZE 1460
+// The maximum length for +CIPRXGET=2 in the manual
+#ifdef TINY_GSM_READ_MAX_SIZE_HEX
+#undef TINY_GSM_READ_MAX_SIZE_HEX
+#endif
+#define TINY_GSM_READ_MAX_SIZE_HEX 730
+// The maximum length for +CIPRXGET=3, which sends each byte as two characters
+
 #ifdef TINY_GSM_SEND_MAX_SIZE
 #undef TINY_GSM_SEND_MAX_SIZE
 #endif
@@ -50,6 +65,12 @@
 // To get the true max size, send the command AT+CIPSEND?
 // I'm choosing to fake it here with 1500
 
+#ifdef TINY_GSM_AT_LINE_MAX
+#undef TINY_GSM_AT_LINE_MAX
+#endif
+#define TINY_GSM_AT_LINE_MAX 554
+// The manual gives 556 characters for a command line, including the "AT"
+
 #ifdef AT_NL
 #undef AT_NL
 #endif
@@ -75,6 +96,7 @@
 
 #include "TinyGsmModem.tpp"
 #include "TinyGsmTCP.tpp"
+#include "TinyGsmUDP.h"
 
 // NOTE: This module supports SSL, but we do not support any certificate
 // management yet. TINY_GSM_MODEM_HAS_SSL here and do no include the SSL module
@@ -181,7 +203,8 @@ class TinyGsmSim800
     TINY_GSM_CLIENT_CONNECT_OVERRIDES
 
     virtual void stop(uint32_t maxWaitMs) {
-      is_mid_send = false;
+      is_mid_send   = false;
+      is_connecting = false;
       dumpModemBuffer(maxWaitMs);
       at->sendAT(GF("+CIPCLOSE="), mux, GF(",1"));  // Quick close
       sock_connected = false;
@@ -388,29 +411,25 @@ class TinyGsmSim800
   bool gprsConnectImpl(const char* apn, const char* user, const char* pwd) {
     gprsDisconnect();
 
+    // These settings go out together as a single command line; their results
+    // are ignored, as they always have been
+    TinyGsmBatch<5> settings(false);
     // Bearer settings for applications based on IP
     // Set the connection type to GPRS
-    sendAT(GF("+SAPBR=3,1,\"Contype\",\"GPRS\""));
-    waitResponse();
-
+    settings.add(GF("+SAPBR=3,1,\"Contype\",\"GPRS\""));
     // Set the APN
-    sendAT(GF("+SAPBR=3,1,\"APN\",\""), apn, '"');
-    waitResponse();
-
+    settings.add(GF("+SAPBR=3,1,\"APN\",\""), apn, GF("\""));
     // Set the user name
     if (user && strnlen(user, 64) > 0) {
-      sendAT(GF("+SAPBR=3,1,\"USER\",\""), user, '"');
-      waitResponse();
+      settings.add(GF("+SAPBR=3,1,\"USER\",\""), user, GF("\""));
     }
     // Set the password
     if (pwd && strnlen(pwd, 128) > 0) {
-      sendAT(GF("+SAPBR=3,1,\"PWD\",\""), pwd, '"');
-      waitResponse();
+      settings.add(GF("+SAPBR=3,1,\"PWD\",\""), pwd, GF("\""));
     }
-
     // Define the PDP context
-    sendAT(GF("+CGDCONT=1,\"IP\",\""), apn, '"');
-    waitResponse();
+    settings.add(GF("+CGDCONT=1,\"IP\",\""), apn, GF("\""));
+    sendBatch(settings);
 
     // Activate the PDP context
     sendAT(GF("+CGACT=1,1"));
@@ -427,17 +446,14 @@ class TinyGsmSim800
     sendAT(GF("+CGATT=1"));
     if (waitResponse(60000L) != 1) { return false; }
 
+    TinyGsmBatch<3> modes;
     // Set to multi-IP
-    sendAT(GF("+CIPMUX=1"));
-    if (waitResponse() != 1) { return false; }
-
+    modes.add(GF("+CIPMUX=1"));
     // Put in "quick send" mode (thus no extra "Send OK")
-    sendAT(GF("+CIPQSEND=1"));
-    if (waitResponse() != 1) { return false; }
-
+    modes.add(GF("+CIPQSEND=1"));
     // Set to get data manually
-    sendAT(GF("+CIPRXGET=1"));
-    if (waitResponse() != 1) { return false; }
+    modes.add(GF("+CIPRXGET=1"));
+    if (!sendBatch(modes)) { return false; }
 
     // Start Task and Set APN, USER NAME, PASSWORD
     sendAT(GF("+CSTT=\""), apn, GF("\",\""), user, GF("\",\""), pwd, '"');
@@ -591,10 +607,30 @@ class TinyGsmSim800
  protected:
   bool modemConnectImpl(const char* host, uint16_t port, uint8_t mux,
                         int timeout_s) {
-    int8_t   rsp;
     uint32_t timeout_ms = ((uint32_t)timeout_s) * 1000;
+    if (!modemStartConnect(host, port, mux)) { return false; }
+    return waitConnectResult(mux, timeout_ms);
+  }
+
+  // The module answers +CIPSTART with OK straight away and reports the
+  // connection later with <mux>, CONNECT OK or <mux>, CONNECT FAIL
+  bool modemConnectAsyncImpl(const char* host, uint16_t port, uint8_t mux) {
+    GsmClientSim800* sock = sockets[mux];
+    sock->stop();
+    TINY_GSM_YIELD();
+    sock->rx.clear();
+    if (!modemStartConnect(host, port, mux) || waitResponse() != 1) {
+      return false;
+    }
+    sock->is_connecting = true;
+    return true;
+  }
+
+  // Sets up SSL for the socket and sends the +CIPSTART command
+  bool modemStartConnect(const char* host, uint16_t port, uint8_t mux) {
 #if !defined(TINY_GSM_MODEM_SIM900)
-    bool ssl = sockets[mux]->is_secure;
+    int8_t rsp;
+    bool   ssl = sockets[mux]->is_secure;
     sendAT(GF("+CIPSSL="), ssl);
     rsp = waitResponse();
     if (ssl && rsp != 1) { return false; }
@@ -611,13 +647,32 @@ class TinyGsmSim800
     if (waitResponse() != 1) return false;
 #endif
 #endif
-    sendAT(GF("+CIPSTART="), mux, ',', GF("\"TCP"), GF("\",\""), host,
-           GF("\","), port);
-    rsp = waitResponse(
-        timeout_ms, GF("CONNECT OK" AT_NL), GF("CONNECT FAIL" AT_NL),
-        GF("ALREADY CONNECT" AT_NL), GF("ERROR" AT_NL),
-        GF("CLOSE OK" AT_NL));  // Happens when HTTPS handshake fails
-    return (1 == rsp);
+    if (sockets[mux]->is_udp) {
+      // AT+CLPORT=<n>,"UDP",<port> - the local port; 0 for any
+      sendAT(GF("+CLPORT="), mux, GF(",\"UDP\","), sockets[mux]->local_port);
+      if (waitResponse() != 1) { return false; }
+    }
+    sendAT(GF("+CIPSTART="), mux, ',',
+           sockets[mux]->is_udp ? GF("\"UDP") : GF("\"TCP"), GF("\",\""),
+           host, GF("\","), port);
+    return true;
+  }
+
+  // +CDNSGIP is answered with OK and then, once the lookup is done, with
+  // +CDNSGIP: 1,"<host>","<ip>"[,"<ip2>"] or +CDNSGIP: 0,<error>
+  bool modemResolveImpl(const char* host, IPAddress& ip, uint32_t timeout_ms) {
+    sendAT(GF("+CDNSGIP=\""), host, '"');
+    if (waitResponse() != 1) { return false; }
+    if (waitResponse(timeout_ms, GF("+CDNSGIP:")) != 1) { return false; }
+    if (streamGetIntBefore(',') != 1) {
+      streamSkipUntil('\n');
+      return false;
+    }
+    streamSkipUntil(',');  // the host
+    streamSkipUntil('"');
+    bool res = ip.fromString(stream.readStringUntil('"'));
+    streamSkipUntil('\n');  // any second address
+    return res;
   }
 
   bool modemBeginSendImpl(size_t len, uint8_t mux) {
@@ -645,12 +700,13 @@ class TinyGsmSim800
     sendAT(GF("+CIPRXGET=2,"), mux, ',', (uint16_t)size);
     if (waitResponse(GF("+CIPRXGET:")) != 1) { return 0; }
 #endif
-    streamSkipUntil(',');  // Skip Rx mode 2/normal or 3/HEX
-    streamSkipUntil(',');  // Skip mux
+    // Rx mode 2/normal or 3/HEX, mux, then the two lengths
+    TinyGsmFields<4, 24> fields;
+    streamGetFields(fields);
     // TODO: validate mux
-    int16_t len_reported = streamGetIntBefore(',');
+    int16_t len_reported = fields.toInt(2, 0);
     //  ^^ Requested number of data bytes (1-1460 bytes) to be read
-    int16_t len_remaining = streamGetIntBefore('\n');
+    int16_t len_remaining = fields.toInt(3, 0);
     // ^^ Confirmed number of data bytes to be read, which may be less than
     // requested. 0 indicates that no data can be read.
     // SRGD NOTE:  Contrary to above (which is copied from AT command manual)
@@ -668,10 +724,11 @@ class TinyGsmSim800
     sendAT(GF("+CIPRXGET=4,"), mux);
     size_t result = 0;
     if (waitResponse(GF("+CIPRXGET:")) == 1) {
-      streamSkipUntil(',');  // Skip mode 4
-      streamSkipUntil(',');  // Skip mux
+      // mode 4, mux, then the length
+      TinyGsmFields<3, 24> fields;
+      streamGetFields(fields);
       // TODO: validate mux
-      result = streamGetIntBefore('\n');
+      result = fields.toInt(2, 0);
       waitResponse();
     }
     // DBG("### Available:", result, "on", mux);
@@ -680,80 +737,59 @@ class TinyGsmSim800
   }
 
   bool modemGetConnectedImpl(uint8_t mux) {
-    sendAT(GF("+CIPSTATUS="), mux);
-    waitResponse(GF("+CIPSTATUS"));
-    int8_t res = waitResponse(GF(",\"CONNECTED\""), GF(",\"CLOSED\""),
-                              GF(",\"CLOSING\""), GF(",\"REMOTE CLOSING\""),
-                              GF(",\"INITIAL\""));
-    waitResponse();
-    return 1 == res;
+    if (!refreshAllSockets()) { return false; }
+    return sockets[mux] && sockets[mux]->sock_connected;
+  }
+
+  bool refreshAllSocketsImpl() {
+    // Without a mux, the state of every connection is listed after the OK:
+    // C: <n>,<bearer>,<"TCP"/"UDP">,<"IP">,<"port">,<"state">
+    sendAT(GF("+CIPSTATUS"));
+    if (waitResponse() != 1) { return false; }
+    // The SIM800 lists six connections and the SIM900 eight; all of the lines
+    // are read, up to the module's last connection, so none are left behind
+    // for the next command, but only the ones used here are kept
+    int16_t muxNo = -1;
+    while (muxNo < TINY_GSM_SIM800_CONNECTIONS - 1) {
+      if (waitResponse(GF("C: ")) != 1) { return false; }
+      muxNo = streamGetIntBefore(',');
+      streamSkipUntil(',');  // Skip bearer
+      streamSkipUntil(',');  // Skip type
+      streamSkipUntil(',');  // Skip remote IP
+      streamSkipUntil(',');  // Skip remote port
+      String state = stream.readStringUntil('\n');
+      if (muxNo >= 0 && muxNo < TINY_GSM_MUX_COUNT && sockets[muxNo]) {
+        sockets[muxNo]->sock_connected = state.indexOf("\"CONNECTED\"") >= 0;
+      }
+    }
+    return true;
   }
 
   /*
    * Utilities
    */
- public:
-  bool handleURCs(String& data) {
-    if (data.endsWith(GF(AT_NL "+CIPRXGET:"))) {
-      int8_t mode = streamGetIntBefore(',');
-      if (mode == 1) {
-        int8_t mux = streamGetIntBefore('\n');
-        if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && sockets[mux]) {
-          sockets[mux]->got_data = true;
-        }
-        data = "";
-        // DBG("### Got Data:", mux);
-        return true;
-      } else {
-        data += mode;
-        return false;
-      }
-    } else if (data.endsWith(GF(AT_NL "+RECEIVE:"))) {
-      int8_t  mux = streamGetIntBefore(',');
-      int16_t len = streamGetIntBefore('\n');
-      if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && sockets[mux]) {
-        sockets[mux]->got_data = true;
-        if (len >= 0 && len <= 1024) { sockets[mux]->sock_available = len; }
-      }
-      data = "";
-      // DBG("### Got Data:", len, "on", mux);
-      return true;
-    } else if (data.endsWith(GF("CLOSED" AT_NL))) {
-      int8_t nl   = data.lastIndexOf(AT_NL, data.length() - 8);
-      int8_t coma = data.indexOf(',', nl + 2);
-      int8_t mux  = data.substring(nl + 2, coma).toInt();
-      if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && sockets[mux]) {
-        sockets[mux]->sock_connected = false;
-      }
-      data = "";
-      DBG("### Closed: ", mux);
-      return true;
-    } else if (data.endsWith(GF("*PSNWID:"))) {
-      streamSkipUntil('\n');  // Refresh network name by network
-      data = "";
-      DBG("### Network name updated.");
-      return true;
-    } else if (data.endsWith(GF("*PSUTTZ:"))) {
-      streamSkipUntil('\n');  // Refresh time and time zone by network
-      data = "";
-      DBG("### Network time and time zone updated.");
-      return true;
-    } else if (data.endsWith(GF("+CTZV:"))) {
-      streamSkipUntil('\n');  // Refresh network time zone by network
-      data = "";
-      DBG("### Network time zone updated.");
-      return true;
-    } else if (data.endsWith(GF("DST:"))) {
-      streamSkipUntil('\n');  // Refresh Network Daylight Saving Time by network
-      data = "";
-      DBG("### Daylight savings time state updated.");
-      return true;
-    }
-    return false;
+ protected:
+  // The unsolicited result codes sent by the module, in priority order
+  static const TinyGsmUrc<TinyGsmSim800>* getURCTableImpl() {
+    static const TinyGsmUrc<TinyGsmSim800> urcs[] = {
+        {GF(AT_NL "+CIPRXGET:"), &TinyGsmSim800::handleURCDataModeMux},
+        {GF(AT_NL "+RECEIVE:"), &TinyGsmSim800::handleURCDataMuxLen},
+        {GF("CLOSED" AT_NL), &TinyGsmSim800::handleURCClosedInData},
+        {GF("CONNECT OK" AT_NL), &TinyGsmSim800::handleURCConnectOkInData},
+        {GF("CONNECT FAIL" AT_NL), &TinyGsmSim800::handleURCConnectFailInData},
+        // Refresh of the network name, time, time zone, and daylight savings
+        // time state by the network
+        {GF("*PSNWID:"), &TinyGsmSim800::handleURCSkipLine},
+        {GF("*PSUTTZ:"), &TinyGsmSim800::handleURCSkipLine},
+        {GF("+CTZV:"), &TinyGsmSim800::handleURCSkipLine},
+        {GF("DST:"), &TinyGsmSim800::handleURCSkipLine},
+        {nullptr, nullptr}};
+    TINY_GSM_CHECK_URC_TABLE(urcs);
+    return urcs;
   }
 
  public:
-  Stream& stream;
+  TinyGsmStream stream;
 
  protected:
   GsmClientSim800* sockets[TINY_GSM_MUX_COUNT];
@@ -10,10 +10,6 @@
 #define SRC_TINYGSMCLIENTSEQUANSMONARCH_H_
 #pragma message("TinyGSM:  TinyGsmClientSequansMonarch")
 
-#if !defined(TINY_GSM_MAX_RESPONSE_CHECKS)
-#define TINY_GSM_MAX_RESPONSE_CHECKS 5
-#endif
-
 #if !defined(TINY_GSM_RX_BUFFER)
 #define TINY_GSM_RX_BUFFER 64
 #endif
@@ -150,14 +146,15 @@ class TinyGsmSequansMonarch
       got_data       = false;
       is_mid_send    = false;
 
-      // adjust for zero indexed socket array vs Sequans' 1 indexed mux numbers
-      // using modulus will force 6 back to 0
+      // Sequans numbers its connections from 1; the mux is kept as the place
+      // in the zero indexed socket array and the module's connection id is
+      // mux + 1
       if (mux >= 1 && mux <= TINY_GSM_MUX_COUNT) {
-        this->mux = mux;
+        this->mux = mux - 1;
       } else {
-        this->mux = (mux % TINY_GSM_MUX_COUNT) + 1;
+        this->mux = mux % TINY_GSM_MUX_COUNT;
       }
-      at->sockets[this->mux % TINY_GSM_MUX_COUNT] = this;
+      at->sockets[this->mux] = this;
 
       return true;
     }
@@ -176,7 +173,7 @@ class TinyGsmSequansMonarch
     virtual void stop(uint32_t maxWaitMs) {
       is_mid_send = false;
       dumpModemBuffer(maxWaitMs);
-      at->sendAT(GF("+SQNSH="), mux);
+      at->sendAT(GF("+SQNSH="), mux + 1);
       sock_connected = false;
       at->waitResponse();
     }
@@ -314,13 +311,14 @@ class TinyGsmSequansMonarch
   }
 
   void maintainImpl() {
-    for (int mux = 1; mux <= TINY_GSM_MUX_COUNT; mux++) {
-      GsmClientSequansMonarch* sock = sockets[mux % TINY_GSM_MUX_COUNT];
-      if (sock && sock->got_data) {
+    TinyGsmMuxMask flagged = takeFlaggedSockets();
+    for (int i = 0; flagged; i++, flagged >>= 1) {
+      GsmClientSequansMonarch* sock = sockets[i];
+      if ((flagged & 1) && sock && sock->got_data) {
         sock->got_data       = false;
-        sock->sock_available = modemGetAvailable(mux);
+        sock->sock_available = modemGetAvailable(sock->mux);
         // modemGetConnected() always checks the state of ALL socks
-        modemGetConnected(1);
+        modemGetConnected(i);
       }
     }
     while (stream.available()) { waitResponse(15, nullptr, nullptr); }
@@ -546,7 +544,7 @@ class TinyGsmSequansMonarch
     if (ssl) {
       // enable SSL and use security profile 1
       // AT+SQNSSCFG=<connId>,<enable>,<spId>
-      sendAT(GF("+SQNSSCFG="), mux, GF(",1,1"));
+      sendAT(GF("+SQNSSCFG="), mux + 1, GF(",1,1"));
       if (waitResponse() != 1) {
         DBG("### WARNING: failed to configure secure socket");
         return false;
@@ -555,7 +553,7 @@ class TinyGsmSequansMonarch
 
     // Socket configuration
     // AT+SQNSCFG:<connId1>, <cid1>, <pktSz1>, <maxTo1>, <connTo1>, <txTo1>
-    // <connId1> = Connection ID = mux
+    // <connId1> = Connection ID = mux + 1
     // <cid1> = PDP context ID = 3 - this is number set up above in the
     // GprsConnect function
     // <pktSz1> = Packet Size, used for online data mode only = 300 (default)
@@ -564,24 +562,24 @@ class TinyGsmSequansMonarch
     //           = 600 (default)
     // <txTo1> = Data sending timeout in hundreds of milliseconds,
     // used for online data mode only = 50 (default)
-    sendAT(GF("+SQNSCFG="), mux, GF(",3,300,90,600,50"));
+    sendAT(GF("+SQNSCFG="), mux + 1, GF(",3,300,90,600,50"));
     waitResponse(5000L);
 
     // Socket configuration extended
     // AT+SQNSCFGEXT:<connId1>, <srMode1>, <recvDataMode1>, <keepalive1>,
     // <listenAutoRsp1>, <sendDataMode1>
-    // <connId1> = Connection ID = mux
+    // <connId1> = Connection ID = mux + 1
     // <srMode1> = Send/Receive URC model = 1 - data amount mode
     // <recvDataMode1> = Receive data mode = 0  - data as text (1 for hex)
     // <keepalive1> = unused = 0
     // <listenAutoRsp1> = Listen auto-response mode = 0 - deactivated
     // <sendDataMode1> = Send data mode = 1  - data as hex (0 for text)
-    sendAT(GF("+SQNSCFGEXT="), mux, GF(",1,0,0,0,1"));
+    sendAT(GF("+SQNSCFGEXT="), mux + 1, GF(",1,0,0,0,1"));
     waitResponse(5000L);
 
     // Socket dial
     // AT+SQNSD=<connId>,<txProt>,<rPort>,<IPaddr>[,<closureType>[,<lPort>[,<connMode>[,acceptAnyRemote]]]]
-    // <connId> = Connection ID = mux
+    // <connId> = Connection ID = mux + 1
     // <txProt> = Transmission protocol = 0 - TCP (1 for UDP)
     // <rPort> = Remote host port to contact
     // <IPaddr> = Any valid IP address in the format xxx.xxx.xxx.xxx or any
@@ -591,7 +589,7 @@ class TinyGsmSequansMonarch
     // <lPort> = UDP connection local port, has no effect for TCP connections.
     // <connMode> = Connection mode = 1 - command mode connection
     // <acceptAnyRemote> = Applies to UDP only
-    sendAT(GF("+SQNSD="), mux, GF(",0,"), port, ',', '"', host, '"',
+    sendAT(GF("+SQNSD="), mux + 1, GF(",0,"), port, ',', '"', host, '"',
            GF(",0,0,1"));
     rsp = waitResponse((timeout_ms - (millis() - startMillis)), GFP(GSM_OK),
                        GFP(GSM_ERROR), GF("NO CARRIER" AT_NL));
@@ -609,7 +607,7 @@ class TinyGsmSequansMonarch
   }
 
   size_t modemSendImpl(const uint8_t* buff, size_t len, uint8_t mux) {
-    if (sockets[mux % TINY_GSM_MUX_COUNT]->sock_connected == false) {
+    if (sockets[mux]->sock_connected == false) {
       DBG("### Sock closed, cannot send data!");
       return 0;
     }
@@ -631,7 +629,7 @@ class TinyGsmSequansMonarch
           sendLength = const_cast<uint8_t*>(buff) + len - txPtr;
         }
 
-        sendAT(GF("+SQNSSENDEXT="), mux, ',', (uint16_t)len);
+        sendAT(GF("+SQNSSENDEXT="), mux + 1, ',', (uint16_t)len);
         send_success &= waitResponse(10000L, GF(AT_NL "> ")) == 1;
         if (!send_success) {
           send_attempts++;
@@ -660,7 +658,7 @@ class TinyGsmSequansMonarch
     // uint8_t nAttempts = 5;
     // bool gotPrompt = false;
     // while (nAttempts > 0 && !gotPrompt) {
-    //   sendAT(GF("+SQNSSEND="), mux);
+    //   sendAT(GF("+SQNSSEND="), mux + 1);
     //   if (waitResponse(5000, GF(AT_NL "> ")) == 1) {
     //     gotPrompt = true;
     //   }
@@ -679,9 +677,36 @@ class TinyGsmSequansMonarch
     // }
     // return 0;
   }
+  // without separate begin and end send commands, send the buffers one at a
+  // time
+  size_t modemSendvImpl(const TinyGsmIoVec* iov, uint8_t count, uint8_t mux) {
+    size_t bytesSent = 0;
+    for (uint8_t i = 0; i < count; i++) {
+      size_t sent = 0;
+      if (!iov[i].flash) {
+        sent = modemSendImpl(static_cast<const uint8_t*>(iov[i].data),
+                             iov[i].len, mux);
+      } else {
+        uint8_t buf[64];
+        while (sent < iov[i].len) {
+          size_t n = TinyGsmMin(iov[i].len - sent, sizeof(buf));
+          for (size_t j = 0; j < n; j++) {
+            buf[j] = TINY_GSM_PGM_CHAR(iov[i].data, sent + j);
+          }
+          size_t s = modemSendImpl(buf, n, mux);
+          sent += s;
+          if (s < n) { break; }
+        }
+      }
+      bytesSent += sent;
+      if (sent < iov[i].len) { break; }
+    }
+    return bytesSent;
+  }
+
 #if 0
   bool modemBeginSendImpl(size_t len, uint8_t mux) {
-    sendAT(GF("+SQNSSENDEXT="), mux, ',', (uint16_t)len);
+    sendAT(GF("+SQNSSENDEXT="), mux + 1, ',', (uint16_t)len);
     return waitResponse(10000L, GF(AT_NL "> ")) == 1;
   }
   size_t modemEndSendImpl(size_t len, uint8_t) {
@@ -694,20 +719,19 @@ class TinyGsmSequansMonarch
 #endif
 
   size_t modemReadImpl(size_t size, uint8_t mux) {
-    sendAT(GF("+SQNSRECV="), mux, ',', (uint16_t)size);
+    sendAT(GF("+SQNSRECV="), mux + 1, ',', (uint16_t)size);
     if (waitResponse(GF("+SQNSRECV: ")) != 1) { return 0; }
     streamSkipUntil(',');  // Skip mux
     // TODO: validate mux
     int16_t len_reported = streamGetIntBefore('\n');
-    size_t  len_read     = moveCharsFromStreamToFifo(mux % TINY_GSM_MUX_COUNT,
-                                                     len_reported);
+    size_t  len_read     = moveCharsFromStreamToFifo(mux, len_reported);
     waitResponse();
-    sockets[mux % TINY_GSM_MUX_COUNT]->sock_available = modemGetAvailable(mux);
+    sockets[mux]->sock_available = modemGetAvailable(mux);
     return len_read;
   }
 
   size_t modemGetAvailableImpl(uint8_t mux) {
-    sendAT(GF("+SQNSI="), mux);
+    sendAT(GF("+SQNSI="), mux + 1);
     size_t result = 0;
     if (waitResponse(GF("+SQNSI:")) == 1) {
       streamSkipUntil(',');  // Skip mux
@@ -722,6 +746,12 @@ class TinyGsmSequansMonarch
   }
 
   bool modemGetConnectedImpl(uint8_t mux) {
+    if (!refreshAllSockets()) { return false; }
+    GsmClientSequansMonarch* sock = sockets[mux];
+    return sock && sock->sock_connected;
+  }
+
+  bool refreshAllSocketsImpl() {
     // This single command always returns the connection status of all
     // six possible sockets.
     sendAT(GF("+SQNSS"));
@@ -743,48 +773,50 @@ class TinyGsmSequansMonarch
       // SOCK_LISTENING              = 4,
       // SOCK_INCOMING               = 5,
       // SOCK_OPENING                = 6,
-      GsmClientSequansMonarch* sock = sockets[muxNo % TINY_GSM_MUX_COUNT];
+      GsmClientSequansMonarch* sock = sockets[muxNo - 1];
       if (sock) {
         sock->sock_connected = ((status != SOCK_CLOSED) &&
                                 (status != SOCK_INCOMING) &&
                                 (status != SOCK_OPENING));
       }
     }
-    waitResponse();  // Should be an OK at the end
-    return sockets[mux % TINY_GSM_MUX_COUNT]->sock_connected;
+    return waitResponse() == 1;  // Should be an OK at the end
   }
 
   /*
    * Utilities
    */
- public:
-  bool handleURCs(String& data) {
-    if (data.endsWith(GF(AT_NL "+SQNSRING:"))) {
-      int8_t  mux = streamGetIntBefore(',');
-      int16_t len = streamGetIntBefore('\n');
-      if (mux >= 0 && mux < TINY_GSM_MUX_COUNT &&
-          sockets[mux % TINY_GSM_MUX_COUNT]) {
-        sockets[mux % TINY_GSM_MUX_COUNT]->got_data       = true;
-        sockets[mux % TINY_GSM_MUX_COUNT]->sock_available = len;
-      }
-      data = "";
-      DBG("### URC Data Received:", len, "on", mux);
-      return true;
-    } else if (data.endsWith(GF("SQNSH: "))) {
-      int8_t mux = streamGetIntBefore('\n');
-      if (mux >= 0 && mux < TINY_GSM_MUX_COUNT &&
-          sockets[mux % TINY_GSM_MUX_COUNT]) {
-        sockets[mux % TINY_GSM_MUX_COUNT]->sock_connected = false;
-      }
-      data = "";
-      DBG("### URC Sock Closed: ", mux);
-      return true;
+ protected:
+  // The unsolicited result codes sent by the module, in priority order
+  static const TinyGsmUrc<TinyGsmSequansMonarch>* getURCTableImpl() {
+    static const TinyGsmUrc<TinyGsmSequansMonarch> urcs[] = {
+        {GF(AT_NL "+SQNSRING:"), &TinyGsmSequansMonarch::handleURCRing},
+        {GF("SQNSH: "), &TinyGsmSequansMonarch::handleURCClosed},
+        {nullptr, nullptr}};
+    TINY_GSM_CHECK_URC_TABLE(urcs);
+    return urcs;
+  }
+
+  // <connId>,<length> - data is waiting in the modem's buffer
+  bool handleURCRing(TinyGsmResponse&) {
+    int8_t  mux = streamGetIntBefore(',') - 1;
+    int16_t len = streamGetIntBefore('\n');
+    if (getURCSocket(mux)) {
+      flagSocket(mux);
+      sockets[mux]->sock_available = len;
     }
-    return false;
+    DBG("### URC Data Received:", len, "on", mux);
+    return true;
+  }
+
+  // <connId> - the socket has been closed
+  bool handleURCClosed(TinyGsmResponse&) {
+    closeURCSocket(streamGetIntBefore('\n') - 1);
+    return true;
   }
 
  public:
-  Stream& stream;
+  TinyGsmStream stream;
 
  protected:
   GsmClientSequansMonarch* sockets[TINY_GSM_MUX_COUNT];
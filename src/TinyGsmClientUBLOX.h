@@ -10,10 +10,6 @@
 #define SRC_TINYGSMCLIENTUBLOX_H_
 #pragma message("TinyGSM:  TinyGsmClientUBLOX")
 
-#if !defined(TINY_GSM_MAX_RESPONSE_CHECKS)
-#define TINY_GSM_MAX_RESPONSE_CHECKS 5
-#endif
-
 #if !defined(TINY_GSM_RX_BUFFER)
 #define TINY_GSM_RX_BUFFER 64
 #endif
@@ -73,6 +69,7 @@
 
 #include "TinyGsmModem.tpp"
 #include "TinyGsmTCP.tpp"
+#include "TinyGsmUDP.h"
 
 // NOTE: This module supports SSL, but we do not support any certificate
 // management yet. TINY_GSM_MODEM_HAS_SSL here and do no include the SSL module
@@ -754,10 +751,18 @@ class TinyGsmUBLOX
                         int timeout_s) {
     uint32_t timeout_ms  = ((uint32_t)timeout_s) * 1000;
     bool     ssl         = sockets[*mux]->is_secure;
+    bool     udp         = sockets[*mux]->is_udp;
+    uint16_t local_port  = sockets[*mux]->local_port;
     uint32_t startMillis = millis();
 
-    // create a socket
-    sendAT(GF("+USOCR=6"));
+    // create a socket; 6 for TCP, 17 for UDP, then the local port if any
+    if (!udp) {
+      sendAT(GF("+USOCR=6"));
+    } else if (!local_port) {
+      sendAT(GF("+USOCR=17"));
+    } else {
+      sendAT(GF("+USOCR=17,"), local_port);
+    }
     // reply is +USOCR: ## of socket created
     if (waitResponse(GF(AT_NL "+USOCR:")) != 1) { return false; }
     *mux = streamGetIntBefore('\n');
@@ -786,6 +791,16 @@ class TinyGsmUBLOX
     return (1 == rsp);
   }
 
+  // +UDNSRN=0 looks up the host's address; the module may take up to 70s
+  bool modemResolveImpl(const char* host, IPAddress& ip, uint32_t timeout_ms) {
+    sendAT(GF("+UDNSRN=0,\""), host, '"');
+    if (waitResponse(timeout_ms, GF(AT_NL "+UDNSRN:")) != 1) { return false; }
+    streamSkipUntil('"');
+    bool res = ip.fromString(stream.readStringUntil('"'));
+    waitResponse();
+    return res;
+  }
+
   bool modemBeginSendImpl(size_t len, uint8_t mux) {
     sendAT(GF("+USOWR="), mux, ',', (uint16_t)len);
     if (waitResponse(GF("@")) != 1) { return 0; }
@@ -868,33 +883,19 @@ class TinyGsmUBLOX
   /*
    * Utilities
    */
- public:
-  bool handleURCs(String& data) {
-    if (data.endsWith(GF("+UUSORD:"))) {
-      int8_t  mux = streamGetIntBefore(',');
-      int16_t len = streamGetIntBefore('\n');
-      if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && sockets[mux]) {
-        sockets[mux]->got_data = true;
-        // max size is 1024
-        if (len >= 0 && len <= 1024) { sockets[mux]->sock_available = len; }
-      }
-      data = "";
-      // DBG("### URC Data Received:", len, "on", mux);
-      return true;
-    } else if (data.endsWith(GF("+UUSOCL:"))) {
-      int8_t mux = streamGetIntBefore('\n');
-      if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && sockets[mux]) {
-        sockets[mux]->sock_connected = false;
-      }
-      data = "";
-      DBG("### URC Sock Closed: ", mux);
-      return true;
-    }
-    return false;
+ protected:
+  // The unsolicited result codes sent by the module, in priority order
+  static const TinyGsmUrc<TinyGsmUBLOX>* getURCTableImpl() {
+    static const TinyGsmUrc<TinyGsmUBLOX> urcs[] = {
+        {GF("+UUSORD:"), &TinyGsmUBLOX::handleURCDataMuxLen},
+        {GF("+UUSOCL:"), &TinyGsmUBLOX::handleURCClosedMux},
+        {nullptr, nullptr}};
+    TINY_GSM_CHECK_URC_TABLE(urcs);
+    return urcs;
   }
 
  public:
-  Stream& stream;
+  TinyGsmStream stream;
 
  protected:
   GsmClientUBLOX* sockets[TINY_GSM_MUX_COUNT];
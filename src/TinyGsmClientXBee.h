@@ -11,10 +11,6 @@
 #define SRC_TINYGSMCLIENTXBEE_H_
 #pragma message("TinyGSM:  TinyGsmClientXBee")
 
-#if !defined(TINY_GSM_MAX_RESPONSE_CHECKS)
-#define TINY_GSM_MAX_RESPONSE_CHECKS 2
-#endif
-
 #if !defined(TINY_GSM_RX_BUFFER)
 #define TINY_GSM_RX_BUFFER 64
 #endif
@@ -184,6 +180,7 @@ class TinyGsmXBee
     }
 
     void stop(uint32_t maxWaitMs) {
+      flushTx();
       at->streamClear();  // Empty anything in the buffer
       // empty the saved currently-in-use destination address
       at->modemStop(maxWaitMs);
@@ -1589,6 +1586,12 @@ class TinyGsmXBee
     }
   }
 
+  // There's only the one socket in transparent mode
+  bool refreshAllSocketsImpl() {
+    if (sockets[0]) { sockets[0]->sock_connected = modemGetConnected(0); }
+    return true;
+  }
+
   /*
    * Utilities
    */
@@ -1600,8 +1603,10 @@ class TinyGsmXBee
     }
   }
   // The XBee has no unsoliliced responses (URC's) when in command mode.
-  bool handleURCs(String&) {
-    return false;
+  static const TinyGsmUrc<TinyGsmXBee>* getURCTableImpl() {
+    static const TinyGsmUrc<TinyGsmXBee> urcs[] = {{nullptr, nullptr}};
+    TINY_GSM_CHECK_URC_TABLE(urcs);
+    return urcs;
   }
 
   bool commandMode(uint8_t retries = 5) {
@@ -1768,7 +1773,7 @@ class TinyGsmXBee
   }
 
  public:
-  Stream& stream;
+  TinyGsmStream stream;
 
  protected:
   GsmClientXBee* sockets[TINY_GSM_MUX_COUNT];
@@ -49,6 +49,9 @@
 typedef const __FlashStringHelper* GsmConstStr;
 #define GFP(x) (reinterpret_cast<GsmConstStr>(x))
 #define GF(x) F(x)
+#define TINY_GSM_PGM_LEN(s) strlen_P(reinterpret_cast<const char*>(s))
+#define TINY_GSM_PGM_CHAR(s, i) \
+  static_cast<char>(pgm_read_byte(reinterpret_cast<const char*>(s) + (i)))
 #elif !defined(TINY_GSM_PROGMEM) && !defined(GFP) && !defined(GF)
 #define TINY_GSM_PROGMEM
 typedef const char* GsmConstStr;
@@ -56,6 +59,14 @@ typedef const char* GsmConstStr;
 #define GF(x) x
 #endif
 
+// Length of and single character access to a string that may be in flash
+#ifndef TINY_GSM_PGM_LEN
+#define TINY_GSM_PGM_LEN(s) strlen(reinterpret_cast<const char*>(s))
+#endif
+#ifndef TINY_GSM_PGM_CHAR
+#define TINY_GSM_PGM_CHAR(s, i) (reinterpret_cast<const char*>(s)[i])
+#endif
+
 #ifdef TINY_GSM_DEBUG
 namespace {
 template <typename T>
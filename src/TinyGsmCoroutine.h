@@ -0,0 +1,328 @@
+/**
+ * @file       TinyGsmCoroutine.h
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ *
+ * @brief C++20 coroutine front end for the background commands, for builds on
+ * a host (ie, a Linux gateway using Arduino compatibility shims).
+ *
+ * Include this after TinyGsmClient.h.  Nothing here is compiled unless the
+ * compiler supports coroutines, so it's harmless on Arduino builds, and the
+ * regular blocking functions of the modems are not changed at all.
+ *
+ * @code
+ * TinyGsmScheduler sched;
+ *
+ * TinyGsmTask<int8_t> signal(TinyGsmScheduler& s, TinyGsm& modem) {
+ *   TinyGsmReply r = co_await s.command(modem, GF("+CSQ"));
+ *   if (r.index != 1) { co_return 99; }
+ *   // r.data holds everything up to the OK: "\r\n+CSQ: 20,0\r\n\r\nOK\r\n"
+ *   co_return r.data.substring(r.data.indexOf(':') + 1).toInt();
+ * }
+ *
+ * sched.add(modem1);
+ * sched.add(modem2);
+ * auto a = signal(sched, modem1);
+ * auto b = signal(sched, modem2);
+ * sched.run();  // both modems make progress in this one thread
+ * @endcode
+ */
+
+#ifndef SRC_TINYGSMCOROUTINE_H_
+#define SRC_TINYGSMCOROUTINE_H_
+
+#ifndef SRC_TINYGSMMODEM_H_
+#error "Include TinyGsmClient.h before TinyGsmCoroutine.h"
+#endif
+
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#define TINY_GSM_HAS_COROUTINES
+#endif
+#endif
+
+#ifdef TINY_GSM_HAS_COROUTINES
+
+#include <coroutine>
+#include <exception>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief What a command awaited through TinyGsmScheduler came back with.
+ */
+struct TinyGsmReply {
+  int8_t index;  ///< The (one based) response received; 0 for a timeout
+  String data;   ///< The text received, up to and including the response
+};
+
+/**
+ * @brief The return type of a coroutine working with the modems.
+ *
+ * The coroutine starts running as soon as it's called and runs until its
+ * first co_await.  Other coroutines can co_await it for its result.
+ *
+ * @tparam T The type of the value given to co_return
+ */
+template <typename T>
+class TinyGsmTask {
+ public:
+  struct promise_type {
+    T                       value{};
+    std::coroutine_handle<> continuation;
+
+    TinyGsmTask get_return_object() {
+      return TinyGsmTask(
+          std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+    std::suspend_never initial_suspend() noexcept {
+      return {};
+    }
+    // stay around once finished so the result can still be read, and pick
+    // up whoever was waiting for us
+    struct FinalAwaiter {
+      bool await_ready() noexcept {
+        return false;
+      }
+      std::coroutine_handle<> await_suspend(
+          std::coroutine_handle<promise_type> h) noexcept {
+        std::coroutine_handle<> next = h.promise().continuation;
+        return next ? next : std::noop_coroutine();
+      }
+      void await_resume() noexcept {}
+    };
+    FinalAwaiter final_suspend() noexcept {
+      return {};
+    }
+    void return_value(T v) {
+      value = std::move(v);
+    }
+    void unhandled_exception() {
+      std::terminate();
+    }
+  };
+  typedef std::coroutine_handle<promise_type> handle;
+
+  TinyGsmTask(TinyGsmTask&& other) noexcept
+      : _h(std::exchange(other._h, nullptr)) {}
+  TinyGsmTask(const TinyGsmTask&)            = delete;
+  TinyGsmTask& operator=(const TinyGsmTask&) = delete;
+  ~TinyGsmTask() {
+    if (_h) { _h.destroy(); }
+  }
+
+  /**
+   * @brief Whether the coroutine has finished
+   */
+  bool done() const {
+    return !_h || _h.done();
+  }
+
+  /**
+   * @brief The value the coroutine returned; only valid once done()
+   */
+  const T& result() const {
+    return _h.promise().value;
+  }
+
+  bool await_ready() const noexcept {
+    return done();
+  }
+  void await_suspend(std::coroutine_handle<> waiting) noexcept {
+    _h.promise().continuation = waiting;
+  }
+  T await_resume() {
+    return _h.promise().value;
+  }
+
+ private:
+  explicit TinyGsmTask(handle h) : _h(h) {}
+  handle _h;
+};
+
+/**
+ * @brief Runs coroutines working with any number of modems in a single
+ * thread.
+ *
+ * Each modem added is polled in turn (see TinyGsmModem::poll()) and the
+ * coroutines waiting on it are resumed as their commands finish.
+ *
+ * @warning The coroutines must only talk to the modems through the scheduler;
+ * a blocking call to a modem with background commands running would take
+ * their responses.
+ */
+class TinyGsmScheduler {
+ public:
+  /**
+   * @brief Add a modem to be polled
+   */
+  template <class Modem>
+  void add(Modem& modem) {
+    _modems.push_back(
+        {&modem, [](void* m) { return static_cast<Modem*>(m)->poll(); }});
+  }
+
+  /**
+   * @brief Poll every modem once and resume the coroutines that are ready
+   *
+   * @return *true* There's still something waiting
+   * @return *false* Everything has finished
+   */
+  bool runOnce() {
+    for (auto& m : _modems) { m.poll(m.modem); }
+    for (size_t i = 0; i < _sleepers.size();) {
+      if (millis() - _sleepers[i].start >= _sleepers[i].ms) {
+        std::coroutine_handle<> h = _sleepers[i].h;
+        _sleepers.erase(_sleepers.begin() + i);
+        h.resume();
+      } else {
+        i++;
+      }
+    }
+    return _waiting > 0 || !_sleepers.empty();
+  }
+
+  /**
+   * @brief Keep going until everything has finished
+   */
+  void run() {
+    while (runOnce()) { TINY_GSM_YIELD(); }
+  }
+
+  template <class Modem>
+  class CommandAwaiter {
+   public:
+    CommandAwaiter(TinyGsmScheduler& sched, Modem& modem, GsmConstStr cmd,
+                   const char* arg, GsmConstStr tail, uint32_t timeout_ms,
+                   GsmConstStr r1, GsmConstStr r2)
+        : _sched(sched), _modem(modem) {
+      _command.set(cmd, arg, tail, timeout_ms);
+      if (r1) { _command.expect(r1, r2); }
+    }
+
+    bool await_ready() const noexcept {
+      return false;
+    }
+    bool await_suspend(std::coroutine_handle<> h) {
+      _h = h;
+      _command.onDone(&CommandAwaiter::finished, this);
+      // if the command can't be queued, carry on right away with a result of 0
+      if (!_modem.submit(_command)) { return false; }
+      _sched._waiting++;
+      return true;
+    }
+    TinyGsmReply await_resume() {
+      return TinyGsmReply{_command.result(),
+                          String(_command.response().c_str())};
+    }
+
+   private:
+    static void finished(TinyGsmCommand& command) {
+      CommandAwaiter* self = static_cast<CommandAwaiter*>(command.context());
+      self->_sched._waiting--;
+      self->_h.resume();
+    }
+
+    TinyGsmScheduler&       _sched;
+    Modem&                  _modem;
+    TinyGsmCommand          _command;
+    std::coroutine_handle<> _h;
+  };
+
+  /**
+   * @brief Send an AT command and wait for the response without blocking
+   *
+   * co_await gives a TinyGsmReply.  Like after a call to waitResponse(),
+   * anything sent after the response is still waiting in the stream; use
+   * waitResponse() to collect it.
+   *
+   * @param modem The modem; it must have been added to this scheduler
+   * @param cmd The command, without the leading "AT"
+   * @param timeout_ms The time to wait for the response
+   * @param r1 The response to wait for; by default "OK"
+   * @param r2 The other response to wait for; by default "ERROR"
+   */
+  template <class Modem>
+  CommandAwaiter<Modem> command(Modem& modem, GsmConstStr cmd,
+                                uint32_t    timeout_ms = 1000L,
+                                GsmConstStr r1         = nullptr,
+                                GsmConstStr r2         = GFP(GSM_ERROR)) {
+    return CommandAwaiter<Modem>(*this, modem, cmd, nullptr, nullptr,
+                                 timeout_ms, r1, r2);
+  }
+
+  /**
+   * @brief Send an AT command with an argument from RAM and wait for the
+   * response without blocking
+   *
+   * @see command(Modem&, GsmConstStr, uint32_t, GsmConstStr, GsmConstStr)
+   */
+  template <class Modem>
+  CommandAwaiter<Modem> command(Modem& modem, GsmConstStr cmd, const char* arg,
+                                GsmConstStr tail, uint32_t timeout_ms = 1000L,
+                                GsmConstStr r1 = nullptr,
+                                GsmConstStr r2 = GFP(GSM_ERROR)) {
+    return CommandAwaiter<Modem>(*this, modem, cmd, arg, tail, timeout_ms, r1,
+                                 r2);
+  }
+
+  /**
+   * @brief Wait for a response without sending anything and without blocking
+   *
+   * @see command(Modem&, GsmConstStr, uint32_t, GsmConstStr, GsmConstStr)
+   */
+  template <class Modem>
+  CommandAwaiter<Modem> waitResponse(Modem& modem, uint32_t timeout_ms = 1000L,
+                                     GsmConstStr r1 = nullptr,
+                                     GsmConstStr r2 = GFP(GSM_ERROR)) {
+    return CommandAwaiter<Modem>(*this, modem, nullptr, nullptr, nullptr,
+                                 timeout_ms, r1, r2);
+  }
+
+  class SleepAwaiter {
+   public:
+    SleepAwaiter(TinyGsmScheduler& sched, uint32_t ms)
+        : _sched(sched), _ms(ms) {}
+    bool await_ready() const noexcept {
+      return _ms == 0;
+    }
+    void await_suspend(std::coroutine_handle<> h) {
+      _sched._sleepers.push_back({h, static_cast<uint32_t>(millis()), _ms});
+    }
+    void await_resume() const noexcept {}
+
+   private:
+    TinyGsmScheduler& _sched;
+    uint32_t          _ms;
+  };
+
+  /**
+   * @brief Let the other coroutines run for a while
+   *
+   * @param ms The time to wait, in milliseconds
+   */
+  SleepAwaiter sleep(uint32_t ms) {
+    return SleepAwaiter(*this, ms);
+  }
+
+ private:
+  struct PolledModem {
+    void* modem;
+    bool (*poll)(void* modem);
+  };
+  struct Sleeper {
+    std::coroutine_handle<> h;
+    uint32_t                start;
+    uint32_t                ms;
+  };
+
+  std::vector<PolledModem> _modems;
+  std::vector<Sleeper>     _sleepers;
+  size_t                   _waiting = 0;  ///< Commands running for coroutines
+};
+
+#endif  // TINY_GSM_HAS_COROUTINES
+
+#endif  // SRC_TINYGSMCOROUTINE_H_
@@ -0,0 +1,118 @@
+/**
+ * @file       TinyGsmDnsCache.h
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ */
+
+#ifndef SRC_TINYGSMDNSCACHE_H_
+#define SRC_TINYGSMDNSCACHE_H_
+
+#include "TinyGsmCommon.h"
+
+#ifndef TINY_GSM_DNS_CACHE_TTL
+// How many seconds a looked up address is used before the host is looked up
+// again
+#define TINY_GSM_DNS_CACHE_TTL 3600
+#endif
+
+#ifndef TINY_GSM_DNS_HOST_MAX
+// The longest host name that is cached; longer names are looked up every time
+#define TINY_GSM_DNS_HOST_MAX 48
+#endif
+
+/**
+ * @brief The addresses of the last few host names looked up, when
+ * TINY_GSM_DNS_CACHE is defined.
+ *
+ * An address is kept for TINY_GSM_DNS_CACHE_TTL seconds.  When every entry is
+ * in use, the one used longest ago is replaced.
+ *
+ * @tparam N The number of host names kept
+ */
+template <uint8_t N>
+class TinyGsmDnsCache {
+  static_assert(N > 0, "TINY_GSM_DNS_CACHE must be at least 1");
+
+ public:
+  /**
+   * @brief Find the address of a host
+   *
+   * @param host The host name
+   * @param ip Set to the address, if it's known
+   * @return *bool* Whether the host has an address that hasn't expired
+   */
+  bool find(const char* host, IPAddress& ip) {
+    Entry* e = lookup(host);
+    if (!e) { return false; }
+    e->used = ++_uses;
+    ip      = e->ip;
+    return true;
+  }
+
+  /**
+   * @brief Keep the address of a host, in place of an expired entry or else
+   * the one used longest ago
+   */
+  void add(const char* host, const IPAddress& ip) {
+    if (strlen(host) > TINY_GSM_DNS_HOST_MAX) { return; }
+    Entry* e = lookup(host);
+    if (!e) {
+      e = &_entries[0];
+      for (uint8_t i = 0; i < N; i++) {
+        if (!fresh(_entries[i])) {
+          e = &_entries[i];
+          break;
+        }
+        if (_entries[i].used < e->used) { e = &_entries[i]; }
+      }
+      strcpy(e->host, host);
+    }
+    e->ip    = ip;
+    e->added = millis();
+    e->used  = ++_uses;
+  }
+
+  /**
+   * @brief Forget the address of a host; ie, after connecting to it failed
+   */
+  void remove(const char* host) {
+    Entry* e = lookup(host);
+    if (e) { e->host[0] = '\0'; }
+  }
+
+  /**
+   * @brief Forget every address
+   */
+  void clear() {
+    for (uint8_t i = 0; i < N; i++) { _entries[i].host[0] = '\0'; }
+  }
+
+ private:
+  struct Entry {
+    char      host[TINY_GSM_DNS_HOST_MAX + 1] = "";
+    IPAddress ip;
+    uint32_t  added = 0;  ///< When the address was looked up
+    uint32_t  used  = 0;  ///< The value of _uses when last used
+  };
+
+  bool fresh(const Entry& e) const {
+    return e.host[0] &&
+        millis() - e.added < TINY_GSM_DNS_CACHE_TTL * 1000UL;
+  }
+
+  Entry* lookup(const char* host) {
+    for (uint8_t i = 0; i < N; i++) {
+      if (fresh(_entries[i]) && !strcmp(_entries[i].host, host)) {
+        return &_entries[i];
+      }
+    }
+    return nullptr;
+  }
+
+  Entry    _entries[N];
+  uint32_t _uses = 0;  ///< Counts every use, to find the least recent
+};
+
+#endif  // SRC_TINYGSMDNSCACHE_H_
@@ -0,0 +1,282 @@
+/**
+ * @file       TinyGsmFields.h
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ */
+
+#ifndef SRC_TINYGSMFIELDS_H_
+#define SRC_TINYGSMFIELDS_H_
+
+#include "TinyGsmCommon.h"
+
+/**
+ * @brief A response line split into its fields.
+ *
+ * The whole line is read from the stream in one go and split in place, so a
+ * response with many values costs a single read with a single timeout,
+ * instead of a separate read for each value.  The values are then converted
+ * straight from the line without any copies.
+ *
+ * Fields are separated by commas (or any other character).  A field in double
+ * quotes may contain the separator; the quotes are removed.  Spaces around a
+ * field are ignored when converting it to a number.
+ *
+ * This class holds the logic; the storage for the line comes from
+ * TinyGsmFields, which is sized at compile time.
+ */
+class TinyGsmFieldList {
+ public:
+  /**
+   * @brief Read a line from a stream and split it into fields
+   *
+   * If the line is longer than the buffer, the rest of it is read and thrown
+   * away.
+   *
+   * @param stream The stream to read from
+   * @param sep The character between fields
+   * @param end The character ending the line; it is read but not kept
+   * @return *uint8_t* The number of fields found; 0 if nothing was received
+   */
+  uint8_t read(Stream& stream, char sep = ',', char end = '\n') {
+    size_t len = stream.readBytesUntil(end, _line, _size - 1);
+    if (len == _size - 1) {
+      // the line didn't fit, throw away the rest of it
+      char skip[16];
+      while (stream.readBytesUntil(end, skip, sizeof(skip)) == sizeof(skip)) {}
+    }
+    if (len && _line[len - 1] == '\r') { len--; }
+    return split(len, sep);
+  }
+
+  /**
+   * @brief Split text that has already been received into fields
+   *
+   * @param text The text; it's copied, so the original isn't changed
+   * @param sep The character between fields
+   * @return *uint8_t* The number of fields found
+   */
+  uint8_t parse(const char* text, char sep = ',') {
+    size_t len = 0;
+    if (text) {
+      for (; len < _size - 1 && text[len]; len++) { _line[len] = text[len]; }
+    }
+    return split(len, sep);
+  }
+
+  /**
+   * @brief The number of fields found
+   */
+  uint8_t count() const {
+    return _count;
+  }
+
+  /**
+   * @brief The text of a (zero-based) field; an empty string if there's no
+   * such field
+   */
+  const char* str(uint8_t i) const {
+    return i < _count ? _line + _starts[i] : "";
+  }
+
+  /**
+   * @brief Whether a (zero-based) field is missing or empty
+   */
+  bool isEmpty(uint8_t i) const {
+    return *str(i) == '\0';
+  }
+
+  /**
+   * @brief A (zero-based) field as an integer
+   *
+   * @param i The field
+   * @param fallback The value to give if the field isn't a number
+   */
+  int32_t toInt(uint8_t i, int32_t fallback = -9999) const {
+    return parseInt(str(i), 255, fallback);
+  }
+
+  /**
+   * @brief Part of a (zero-based) field as an integer; ie, the year of a time
+   * stamp like "20240117123456.000"
+   *
+   * @param i The field
+   * @param from The first character to use
+   * @param len The number of characters to use
+   * @param fallback The value to give if that part isn't a number
+   */
+  int32_t toInt(uint8_t i, uint8_t from, uint8_t len,
+                int32_t fallback = -9999) const {
+    const char* s = str(i);
+    for (uint8_t k = 0; k < from; k++) {
+      if (!s[k]) { return fallback; }
+    }
+    return parseInt(s + from, len, fallback);
+  }
+
+  /**
+   * @brief A (zero-based) field with a decimal fraction as a scaled integer;
+   * ie, "31.2215" with 6 decimals is 31221500
+   *
+   * Any further decimals are cut off.
+   *
+   * @param i The field
+   * @param decimals The number of decimals to keep
+   * @param fallback The value to give if the field isn't a number
+   */
+  int32_t toFixed(uint8_t i, uint8_t decimals,
+                  int32_t fallback = -9999) const {
+    const char* s = skipSpaces(str(i));
+    bool        neg = signOf(s);
+    if (!isDigit(*s) && !(*s == '.' && isDigit(s[1]))) { return fallback; }
+    int32_t v = 0;
+    while (isDigit(*s)) { v = v * 10 + (*s++ - '0'); }
+    if (*s == '.') { s++; }
+    for (uint8_t d = 0; d < decimals; d++) {
+      v = v * 10;
+      if (isDigit(*s)) { v += *s++ - '0'; }
+    }
+    return neg ? -v : v;
+  }
+
+  /**
+   * @brief A (zero-based) field as a float
+   *
+   * Only plain decimal notation is understood (no exponents), which is all
+   * the modules send.
+   *
+   * @param i The field
+   * @param fallback The value to give if the field isn't a number
+   */
+  float toFloat(uint8_t i, float fallback = -9999.0F) const {
+    const char* s = skipSpaces(str(i));
+    bool        neg = signOf(s);
+    if (!isDigit(*s) && !(*s == '.' && isDigit(s[1]))) { return fallback; }
+    // collect the digits as an integer, as far as it goes without overflow,
+    // then scale it once at the end
+    uint32_t mantissa = 0;
+    int8_t   scale    = 0;
+    while (isDigit(*s)) {
+      if (mantissa < 100000000UL) {
+        mantissa = mantissa * 10 + (*s - '0');
+      } else {
+        scale++;
+      }
+      s++;
+    }
+    if (*s == '.') {
+      s++;
+      while (isDigit(*s)) {
+        if (mantissa < 100000000UL) {
+          mantissa = mantissa * 10 + (*s - '0');
+          scale--;
+        }
+        s++;
+      }
+    }
+    float p = 1.0F;
+    for (int8_t k = scale < 0 ? -scale : scale; k > 0; k--) { p *= 10.0F; }
+    float v = scale < 0 ? mantissa / p : mantissa * p;
+    return neg ? -v : v;
+  }
+
+ protected:
+  TinyGsmFieldList(char* line, uint8_t* starts, size_t size, uint8_t capacity)
+      : _line(line),
+        _starts(starts),
+        _size(size),
+        _capacity(capacity),
+        _count(0) {}
+
+  // the line belongs to the derived class; a copy would share it
+  TinyGsmFieldList(const TinyGsmFieldList&)            = delete;
+  TinyGsmFieldList& operator=(const TinyGsmFieldList&) = delete;
+
+ private:
+  // Split the first len characters of the line into fields, in place
+  uint8_t split(size_t len, char sep) {
+    _line[len]   = '\0';
+    _count       = 0;
+    bool   quote = false;
+    size_t out   = 0;  // quotes are dropped, so the text moves down
+    _starts[_count++] = 0;
+    for (size_t in = 0; in < len; in++) {
+      char c = _line[in];
+      if (c == '"') {
+        quote = !quote;
+      } else if (c == sep && !quote && _count < _capacity) {
+        _line[out++]      = '\0';
+        _starts[_count++] = out;
+      } else {
+        _line[out++] = c;
+      }
+    }
+    _line[out] = '\0';
+    if (!len) { _count = 0; }
+    return _count;
+  }
+
+  static bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+  }
+
+  static const char* skipSpaces(const char* s) {
+    while (*s == ' ') { s++; }
+    return s;
+  }
+
+  // Step over a sign, if there is one; true if it's negative
+  static bool signOf(const char*& s) {
+    if (*s == '-') {
+      s++;
+      return true;
+    }
+    if (*s == '+') { s++; }
+    return false;
+  }
+
+  // Convert at most len characters, or up to the end of the text
+  static int32_t parseInt(const char* s, uint8_t len, int32_t fallback) {
+    while (len && *s == ' ') {
+      s++;
+      len--;
+    }
+    bool neg = false;
+    if (len && (*s == '-' || *s == '+')) {
+      neg = *s++ == '-';
+      len--;
+    }
+    if (!len || !isDigit(*s)) { return fallback; }
+    int32_t v = 0;
+    for (; len && isDigit(*s); len--) { v = v * 10 + (*s++ - '0'); }
+    return neg ? -v : v;
+  }
+
+  char*    _line;      ///< The line, split into fields in place
+  uint8_t* _starts;    ///< Where each field starts in the line
+  size_t   _size;      ///< The size of the line buffer
+  uint8_t  _capacity;  ///< The maximum number of fields
+  uint8_t  _count;     ///< The number of fields found
+};
+
+/**
+ * @brief A TinyGsmFieldList with room for N fields in a line of up to L - 1
+ * characters
+ *
+ * Fields after the first N are left attached to the last one.
+ *
+ * @tparam N The maximum number of fields
+ * @tparam L The size of the line buffer
+ */
+template <uint8_t N, uint8_t L = 64>
+class TinyGsmFields : public TinyGsmFieldList {
+ public:
+  TinyGsmFields() : TinyGsmFieldList(_line, _starts, L, N) {}
+
+ private:
+  char    _line[L];
+  uint8_t _starts[N];
+};
+
+#endif  // SRC_TINYGSMFIELDS_H_
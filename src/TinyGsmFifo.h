@@ -1,8 +1,17 @@
 #ifndef TinyGsmFifo_h
 #define TinyGsmFifo_h
 
-template <class T, unsigned N>
+/**
+ * @brief A circular buffer of N items of type T.
+ *
+ * This is the version for any size; it keeps one position free to tell a full
+ * buffer from an empty one and wraps the positions with a modulo.  When N is a
+ * power of two, the specialization below is used instead.
+ */
+template <class T, unsigned N, bool PowerOfTwo = (N & (N - 1)) == 0>
 class TinyGsmFifo {
+  static_assert(N > 1, "A TinyGsmFifo needs room for at least 2 items");
+
  public:
   /**
    * @brief Construct a new Tiny Gsm Fifo object, setting the head and tail to
@@ -87,7 +96,7 @@ class TinyGsmFifo {
       int m = N - w;
       // check wrap
       if (f > m) f = m;
-      memcpy(&_b[w], p, f);
+      memcpy(&_b[w], p, f * sizeof(T));
       _w = _inc(w, f);
       c -= f;
       p += f;
@@ -95,6 +104,38 @@ class TinyGsmFifo {
     return n - c;
   }
 
+  /**
+   * @brief Get the free space that can be written in one go, so items can be
+   * read or decoded straight into the buffer.
+   *
+   * The free space may wrap around the end of the buffer, so after
+   * committing this span there may be a second one.
+   *
+   * @param len Set to the number of items that can be written
+   * @return Where to write them
+   */
+  T* writeSpan(size_t& len) {
+    int w = _w;
+    int s = _r - w;  // space up to the read position...
+    if (s <= 0) {
+      s = N - w;  // ...or up to the end of the buffer
+      if (_r == 0) s--;
+    } else {
+      s--;
+    }
+    len = s;
+    return &_b[w];
+  }
+
+  /**
+   * @brief Add items written into the span from writeSpan() to the buffer
+   *
+   * @param n The number of items written; no more than the span's length
+   */
+  void commit(size_t n) {
+    _w = _inc(_w, n);
+  }
+
   // reading thread/context API
   // --------------------------------------------------------
 
@@ -134,7 +175,7 @@ class TinyGsmFifo {
       int m = N - r;
       // check wrap
       if (f > m) f = m;
-      memcpy(p, &_b[r], f);
+      memcpy(p, &_b[r], f * sizeof(T));
       _r = _inc(r, f);
       c -= f;
       p += f;
@@ -147,6 +188,33 @@ class TinyGsmFifo {
     return _b[_r];
   }
 
+  /**
+   * @brief Get the items that can be read in one go, so they can be used
+   * in place without copying them out.
+   *
+   * The items may wrap around the end of the buffer, so after consuming this
+   * span there may be a second one.
+   *
+   * @param len Set to the number of items in the span
+   * @return The first item
+   */
+  const T* readSpan(size_t& len) {
+    int r = _r;
+    int s = _w - r;
+    if (s < 0) s = N - r;  // the rest is at the start of the buffer
+    len = s;
+    return &_b[r];
+  }
+
+  /**
+   * @brief Remove items read through readSpan() from the buffer
+   *
+   * @param n The number of items used; no more than the span's length
+   */
+  void consume(size_t n) {
+    _r = _inc(_r, n);
+  }
+
  private:
   /**
    * @brief Get the next increment spot in the buffer, accounting for the size
@@ -165,4 +233,138 @@ class TinyGsmFifo {
   int _r = 0;   /// The read position in the buffer
 };
 
+/**
+ * @brief A circular buffer of N items of type T, for N a power of two.
+ *
+ * The read and write positions run freely and are only masked down to an
+ * index when the buffer is accessed, so there's no division on any access and
+ * every one of the N positions can be used.  The positions are unsigned, so
+ * wrapping them around is well defined, and the difference between them is
+ * always the number of items in the buffer.
+ */
+template <class T, unsigned N>
+class TinyGsmFifo<T, N, true> {
+  static_assert(N > 1, "A TinyGsmFifo needs room for at least 2 items");
+
+ public:
+  TinyGsmFifo() {
+    clear();
+  }
+
+  void clear() {
+    _r = 0;
+    _w = 0;
+  }
+
+  // writing thread/context API
+  //-------------------------------------------------------------
+
+  bool writeable(void) {
+    return free() > 0;
+  }
+
+  int free(void) {
+    return N - static_cast<unsigned>(_w - _r);
+  }
+
+  bool put(const T& c) {
+    unsigned w = _w;
+    if (w - _r == N) return false;  // full
+    _b[w & MASK] = c;
+    _w           = w + 1;
+    return true;
+  }
+
+  int put(const T* p, int n, bool t = false) {
+    int c = n;
+    while (c) {
+      int f;
+      while ((f = free()) == 0) {
+        if (!t) return n - c;  // no more space and not blocking
+      }
+      if (c < f) f = c;
+      unsigned w = _w;
+      int      m = N - (w & MASK);
+      if (f > m) f = m;  // stop at the end of the buffer
+      memcpy(&_b[w & MASK], p, f * sizeof(T));
+      _w = w + f;
+      c -= f;
+      p += f;
+    }
+    return n - c;
+  }
+
+  T* writeSpan(size_t& len) {
+    unsigned w = _w & MASK;
+    unsigned f = free();
+    len        = f < N - w ? f : N - w;
+    return &_b[w];
+  }
+
+  void commit(size_t n) {
+    _w += n;
+  }
+
+  // reading thread/context API
+  // --------------------------------------------------------
+
+  bool readable(void) {
+    return _r != _w;
+  }
+
+  size_t size(void) {
+    return static_cast<unsigned>(_w - _r);
+  }
+
+  bool get(T* p) {
+    unsigned r = _r;
+    if (r == _w) return false;  // !readable()
+    *p = _b[r & MASK];
+    _r = r + 1;
+    return true;
+  }
+
+  int get(T* p, int n, bool t = false) {
+    int c = n;
+    while (c) {
+      int f;
+      while ((f = size()) == 0) {
+        if (!t) return n - c;  // nothing left and not blocking
+      }
+      if (c < f) f = c;
+      unsigned r = _r;
+      int      m = N - (r & MASK);
+      if (f > m) f = m;  // stop at the end of the buffer
+      memcpy(p, &_b[r & MASK], f * sizeof(T));
+      _r = r + f;
+      c -= f;
+      p += f;
+    }
+    return n - c;
+  }
+
+  int peek() {
+    if (!readable()) { return -1; }
+    return _b[_r & MASK];
+  }
+
+  const T* readSpan(size_t& len) {
+    unsigned r = _r & MASK;
+    unsigned s = size();
+    len        = s < N - r ? s : N - r;
+    return &_b[r];
+  }
+
+  void consume(size_t n) {
+    _r += n;
+  }
+
+ private:
+  static const unsigned MASK = N - 1;
+
+  T        _b[N]{};  /// The buffer, containing 'N' items of type 'T'
+  unsigned _w = 0;   /// The number of items ever written, wrapping around
+  unsigned _r = 0;   /// The number of items ever read, wrapping around
+};
+
 #endif
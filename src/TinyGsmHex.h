@@ -0,0 +1,120 @@
+/**
+ * @file       TinyGsmHex.h
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ */
+
+#ifndef SRC_TINYGSMHEX_H_
+#define SRC_TINYGSMHEX_H_
+
+#include "TinyGsmCommon.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// The value of each ASCII character as a hex digit; -1 if it isn't one
+static const int8_t TinyGsmHexValues[128] TINY_GSM_PROGMEM = {
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  //
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  //
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  //
+    0,  1,  2,  3,  4,  5,  6,  7,  8,  9,  -1, -1, -1, -1, -1, -1,  //
+    -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,  //
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  //
+    -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,  //
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  //
+};
+
+static const char TinyGsmHexDigits[] TINY_GSM_PROGMEM = "0123456789ABCDEF";
+
+/**
+ * @brief The byte written as two hex digits; -1 if either isn't a hex digit
+ */
+static inline int16_t TinyGsmHexByte(char hi, char lo) {
+  if ((hi | lo) & 0x80) { return -1; }
+  int8_t h = static_cast<int8_t>(
+      TINY_GSM_PGM_CHAR(TinyGsmHexValues, static_cast<uint8_t>(hi)));
+  int8_t l = static_cast<int8_t>(
+      TINY_GSM_PGM_CHAR(TinyGsmHexValues, static_cast<uint8_t>(lo)));
+  if ((h | l) < 0) { return -1; }
+  return (h << 4) | l;
+}
+
+#if defined(__SSE2__)
+// Decode 16 hex digits into 8 bytes; false, with nothing written, if any of
+// them isn't a hex digit
+static inline bool TinyGsmHexDecode16(const char* in, uint8_t* out) {
+  __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+  // the signed compares also turn away everything from 0x80 up
+  __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('0' - 1)),
+                                _mm_cmplt_epi8(v, _mm_set1_epi8('9' + 1)));
+  __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+  __m128i alpha = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+                                _mm_cmplt_epi8(lower, _mm_set1_epi8('f' + 1)));
+  if (_mm_movemask_epi8(_mm_or_si128(digit, alpha)) != 0xFFFF) {
+    return false;
+  }
+  // '0'-'9' end in 0-9 and 'A'-'F'/'a'-'f' in 1-6, which need 9 more
+  __m128i nibbles = _mm_add_epi8(_mm_and_si128(v, _mm_set1_epi8(0x0F)),
+                                 _mm_and_si128(alpha, _mm_set1_epi8(9)));
+  // each 16 bit lane holds a pair: the high digit in its low byte
+  __m128i hi    = _mm_and_si128(_mm_slli_epi16(nibbles, 4), _mm_set1_epi16(0xF0));
+  __m128i lo    = _mm_srli_epi16(nibbles, 8);
+  __m128i bytes = _mm_or_si128(hi, lo);
+  _mm_storel_epi64(reinterpret_cast<__m128i*>(out),
+                   _mm_packus_epi16(bytes, bytes));
+  return true;
+}
+#endif
+
+/**
+ * @brief Decode hex digit pairs into bytes
+ *
+ * Pairs with anything but a hex digit in them are skipped.  The output may
+ * be the same buffer as the input, so hex text can be read into the place
+ * the data should end up and decoded there.
+ *
+ * @param in The hex digits; upper or lower case
+ * @param len The number of digits; an odd one at the end is ignored
+ * @param out Where to put the bytes; room for len / 2 of them
+ * @return *size_t* The number of bytes written; less than len / 2 if any of
+ * the pairs weren't valid
+ */
+static inline size_t TinyGsmHexDecode(const char* in, size_t len,
+                                      uint8_t* out) {
+  size_t pairs = len / 2;
+  size_t n     = 0;
+  size_t i     = 0;
+#if defined(__SSE2__)
+  // the whole block is loaded before anything is stored, and the stores stay
+  // behind the loads, so decoding in place is safe
+  while (i + 8 <= pairs && TinyGsmHexDecode16(in + 2 * i, out + n)) {
+    i += 8;
+    n += 8;
+  }
+#endif
+  for (; i < pairs; i++) {
+    int16_t b = TinyGsmHexByte(in[2 * i], in[2 * i + 1]);
+    if (b >= 0) { out[n++] = static_cast<uint8_t>(b); }
+  }
+  return n;
+}
+
+/**
+ * @brief Write bytes as upper case hex digit pairs
+ *
+ * @param in The bytes
+ * @param len The number of bytes
+ * @param out Where to put the digits; room for 2 * len of them, no
+ * terminating null is added
+ */
+static inline void TinyGsmHexEncode(const uint8_t* in, size_t len, char* out) {
+  for (size_t i = 0; i < len; i++) {
+    *out++ = TINY_GSM_PGM_CHAR(TinyGsmHexDigits, in[i] >> 4);
+    *out++ = TINY_GSM_PGM_CHAR(TinyGsmHexDigits, in[i] & 0x0F);
+  }
+}
+
+#endif  // SRC_TINYGSMHEX_H_
@@ -0,0 +1,115 @@
+/**
+ * @file       TinyGsmIoVec.h
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ */
+
+#ifndef SRC_TINYGSMIOVEC_H_
+#define SRC_TINYGSMIOVEC_H_
+
+#include "TinyGsmCommon.h"
+
+/**
+ * @brief One of the buffers given to GsmClient::writev(); in RAM or, for
+ * F() strings and PROGMEM data, in flash.
+ *
+ * ie, to send an MQTT packet in one go:
+ *
+ *     TinyGsmIoVec packet[] = {{header, 2}, {F("sensors/temp")}, {buf, len}};
+ *     client.writev(packet, 3);
+ */
+struct TinyGsmIoVec {
+  /**
+   * @brief A buffer in RAM
+   */
+  TinyGsmIoVec(const void* data, size_t len)
+      : data(data),
+        len(len),
+        flash(false) {}
+
+  /**
+   * @brief A null terminated string in RAM, without the null
+   */
+  TinyGsmIoVec(const char* str)
+      : data(str),
+        len(str ? strlen(str) : 0),
+        flash(false) {}
+
+  /**
+   * @brief An F() string, without the null
+   */
+  TinyGsmIoVec(const __FlashStringHelper* str)
+      : data(str),
+        len(str ? TINY_GSM_PGM_LEN(str) : 0),
+        flash(true) {}
+
+  /**
+   * @brief A buffer in flash; ie, GFP() of a PROGMEM array
+   */
+  TinyGsmIoVec(const __FlashStringHelper* data, size_t len)
+      : data(data),
+        len(len),
+        flash(true) {}
+
+  const void* data;   ///< The first byte
+  size_t      len;    ///< The number of bytes
+  bool        flash;  ///< Whether the bytes are in flash
+};
+
+/**
+ * @brief The number of bytes in all of the buffers together
+ */
+static inline size_t TinyGsmIoVecLength(const TinyGsmIoVec* iov,
+                                        uint8_t             count) {
+  size_t len = 0;
+  for (uint8_t i = 0; i < count; i++) { len += iov[i].len; }
+  return len;
+}
+
+/**
+ * @brief Write part of the buffers, as if they were one, to a stream
+ *
+ * @param out Where to write
+ * @param iov The buffers
+ * @param count The number of buffers
+ * @param from The position in all of the buffers together to start at
+ * @param len The number of bytes to write
+ * @return *size_t* The number of bytes written; less than len if the stream
+ * stopped taking them
+ */
+static inline size_t TinyGsmIoVecWrite(Print& out, const TinyGsmIoVec* iov,
+                                       uint8_t count, size_t from,
+                                       size_t len) {
+  size_t written = 0;
+  for (uint8_t i = 0; i < count && written < len; i++) {
+    if (from >= iov[i].len) {
+      from -= iov[i].len;
+      continue;
+    }
+    size_t n = TinyGsmMin(iov[i].len - from, len - written);
+    size_t w = 0;
+    if (!iov[i].flash) {
+      w = out.write(static_cast<const uint8_t*>(iov[i].data) + from, n);
+    } else {
+      // copy flash to RAM a piece at a time so the stream still gets blocks
+      uint8_t buf[32];
+      while (w < n) {
+        size_t k = TinyGsmMin(n - w, sizeof(buf));
+        for (size_t j = 0; j < k; j++) {
+          buf[j] = TINY_GSM_PGM_CHAR(iov[i].data, from + w + j);
+        }
+        size_t put = out.write(buf, k);
+        w += put;
+        if (put < k) { break; }
+      }
+    }
+    written += w;
+    if (w < n) { break; }
+    from = 0;
+  }
+  return written;
+}
+
+#endif  // SRC_TINYGSMIOVEC_H_
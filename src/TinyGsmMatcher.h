@@ -0,0 +1,220 @@
+/**
+ * @file       TinyGsmMatcher.h
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ */
+
+#ifndef SRC_TINYGSMMATCHER_H_
+#define SRC_TINYGSMMATCHER_H_
+
+#include "TinyGsmCommon.h"
+
+#ifndef TINY_GSM_MATCHER_TABLE
+// The bytes set aside per pattern, on average, for the fall back tables that
+// are worked out as patterns are added; a pattern that doesn't fit works out
+// its fall backs as it goes instead.  AVR boards are short of RAM, so they go
+// without by default.
+#if defined(__AVR__) || defined(ARDUINO_ARCH_AVR)
+#define TINY_GSM_MATCHER_TABLE 0
+#else
+#define TINY_GSM_MATCHER_TABLE 16
+#endif
+#endif
+
+/**
+ * @brief A streaming matcher for a small set of patterns.
+ *
+ * The matcher is fed the incoming stream one character at a time and reports
+ * when the text received so far ends with one of its patterns - the same
+ * answer as calling `endsWith()` for every pattern on every character, but
+ * without rescanning the received text.
+ *
+ * For each pattern the matcher keeps only the length of the longest prefix of
+ * the pattern that is also a suffix of the received text.  A step is a single
+ * character comparison per pattern in the common case.  On a mismatch the
+ * matcher falls back to the next shorter candidate prefix (the KMP "failure"
+ * value).  The failure values of each pattern are worked out once, when it's
+ * added, into a table in RAM; the patterns themselves can stay in flash.  If
+ * the table space runs out, the remaining patterns work out their failure
+ * values from the pattern on each mismatch instead, which gives the same
+ * result more slowly.
+ *
+ * This class holds the logic; the storage for the patterns comes from
+ * TinyGsmMatcher, which is sized at compile time.  This way code that works
+ * with a matcher doesn't need to be a template on its size.
+ */
+class TinyGsmPatternMatcher {
+ public:
+  /**
+   * @brief Add a pattern to the set
+   *
+   * A null or empty pattern takes up a slot but never matches; this keeps
+   * the slot numbers equal to the argument positions of waitResponse.
+   *
+   * @param pattern The text to look for; may be in flash on AVR
+   * @return *int8_t* The one-based slot of the pattern, 0 if the matcher is
+   * full
+   */
+  int8_t add(GsmConstStr pattern) {
+    if (_count >= _capacity) { return 0; }
+    uint8_t len       = pattern ? TINY_GSM_PGM_LEN(pattern) : 0;
+    _patterns[_count] = pattern;
+    _lens[_count]     = len;
+    _pos[_count]      = 0;
+    _tables[_count]   = buildTable(pattern, len);
+    return ++_count;
+  }
+
+  /**
+   * @brief Remove all of the patterns
+   */
+  void clear() {
+    _count      = 0;
+    _table_used = 0;
+  }
+
+  /**
+   * @brief Forget any partial matches, i.e., start over as if no characters
+   * had been received.
+   */
+  void reset() {
+    for (uint8_t i = 0; i < _count; i++) { _pos[i] = 0; }
+  }
+
+  /**
+   * @brief Feed the next received character to the matcher
+   *
+   * @param c The character
+   * @return *int8_t* The one-based slot of the first pattern the received text
+   * now ends with, or 0 if there is no match
+   */
+  int8_t step(char c) {
+    int8_t hit = 0;
+    for (uint8_t i = 0; i < _count; i++) {
+      uint8_t len = _lens[i];
+      if (!len) { continue; }
+      GsmConstStr p = _patterns[i];
+      uint8_t     k = _pos[i];
+      while (k && TINY_GSM_PGM_CHAR(p, k) != c) { k = fallback(i, k); }
+      if (TINY_GSM_PGM_CHAR(p, k) == c) { k++; }
+      if (k == len) {
+        if (!hit) { hit = i + 1; }
+        // keep any overlap so back-to-back patterns are still found
+        k = fallback(i, k);
+      }
+      _pos[i] = k;
+    }
+    return hit;
+  }
+
+  /**
+   * @brief The number of slots in use
+   */
+  uint8_t count() const {
+    return _count;
+  }
+
+  /**
+   * @brief The pattern in a (one-based) slot
+   */
+  GsmConstStr pattern(uint8_t slot) const {
+    return slot && slot <= _count ? _patterns[slot - 1] : nullptr;
+  }
+
+ protected:
+  TinyGsmPatternMatcher(GsmConstStr* patterns, uint8_t* lens, uint8_t* pos,
+                        uint16_t* tables, uint8_t capacity, uint8_t* table,
+                        uint16_t table_size)
+      : _patterns(patterns),
+        _lens(lens),
+        _pos(pos),
+        _tables(tables),
+        _table(table),
+        _table_size(table_size),
+        _table_used(0),
+        _capacity(capacity),
+        _count(0) {}
+
+  // the storage belongs to the derived class, so copies would share it
+  TinyGsmPatternMatcher(const TinyGsmPatternMatcher&)            = delete;
+  TinyGsmPatternMatcher& operator=(const TinyGsmPatternMatcher&) = delete;
+
+ private:
+  // Marks a pattern whose failure values didn't fit in the table
+  static const uint16_t NO_TABLE = 0xFFFF;
+
+  // Work out the failure value for every prefix length of a pattern into the
+  // table; returns where they start, or NO_TABLE if there's no room
+  uint16_t buildTable(GsmConstStr p, uint8_t len) {
+    if (!len || len > _table_size - _table_used) { return NO_TABLE; }
+    uint16_t at = _table_used;
+    _table_used += len;
+    // f[k - 1] is the failure value for the first k characters
+    uint8_t* f = _table + at;
+    f[0]       = 0;
+    uint8_t j  = 0;
+    for (uint8_t k = 1; k < len; k++) {
+      char c = TINY_GSM_PGM_CHAR(p, k);
+      while (j && TINY_GSM_PGM_CHAR(p, j) != c) { j = f[j - 1]; }
+      if (TINY_GSM_PGM_CHAR(p, j) == c) { j++; }
+      f[k] = j;
+    }
+    return at;
+  }
+
+  // The length of the longest proper prefix of a pattern that is also a
+  // suffix of its first k characters
+  uint8_t fallback(uint8_t i, uint8_t k) const {
+    if (_tables[i] != NO_TABLE) { return _table[_tables[i] + k - 1]; }
+    return scanFallback(_patterns[i], k);
+  }
+
+  // The same, worked out from the pattern itself for a pattern without a
+  // table
+  static uint8_t scanFallback(GsmConstStr p, uint8_t k) {
+    for (uint8_t j = k - 1; j > 0; j--) {
+      uint8_t m = 0;
+      while (m < j &&
+             TINY_GSM_PGM_CHAR(p, m) == TINY_GSM_PGM_CHAR(p, k - j + m)) {
+        m++;
+      }
+      if (m == j) { return j; }
+    }
+    return 0;
+  }
+
+  GsmConstStr* _patterns;    ///< The patterns, in slot order
+  uint8_t*     _lens;        ///< The length of each pattern
+  uint8_t*     _pos;         ///< The length matched so far for each pattern
+  uint16_t*    _tables;      ///< Where each pattern's failure values start
+  uint8_t*     _table;       ///< The failure values of all of the patterns
+  uint16_t     _table_size;  ///< The size of the table
+  uint16_t     _table_used;  ///< The part of the table in use
+  uint8_t      _capacity;    ///< The number of slots available
+  uint8_t      _count;       ///< The number of slots in use
+};
+
+/**
+ * @brief A TinyGsmPatternMatcher with room for N patterns
+ *
+ * @tparam N The maximum number of patterns
+ * @tparam T The size of the table of failure values, in bytes; by default
+ * TINY_GSM_MATCHER_TABLE per pattern
+ */
+template <uint8_t N, uint16_t T = N * TINY_GSM_MATCHER_TABLE>
+class TinyGsmMatcher : public TinyGsmPatternMatcher {
+ public:
+  TinyGsmMatcher()
+      : TinyGsmPatternMatcher(_patterns, _lens, _pos, _tables, N, _table, T) {}
+
+ private:
+  GsmConstStr _patterns[N];
+  uint8_t     _lens[N];
+  uint8_t     _pos[N];
+  uint16_t    _tables[N];
+  uint8_t     _table[T ? T : 1];
+};
+
+#endif  // SRC_TINYGSMMATCHER_H_
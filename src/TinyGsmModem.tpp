@@ -10,6 +10,14 @@
 #define SRC_TINYGSMMODEM_H_
 
 #include "TinyGsmCommon.h"
+#include "TinyGsmBatch.h"
+#include "TinyGsmBufferedStream.h"
+#include "TinyGsmFields.h"
+#include "TinyGsmMatcher.h"
+#include "TinyGsmResponseBuffer.h"
+#ifdef TINY_GSM_STATS
+#include "TinyGsmStats.h"
+#endif
 
 #ifndef AT_NL
 #define AT_NL "\r\n"
@@ -23,7 +31,7 @@
 #define AT_ERROR "ERROR"
 #endif
 
-#if defined TINY_GSM_DEBUG
+#if defined TINY_GSM_DEBUG || defined TINY_GSM_STATS
 #ifndef AT_VERBOSE
 #define AT_VERBOSE "+CME ERROR:"
 #endif
@@ -33,8 +41,30 @@
 #endif
 #endif
 
-#ifndef TINY_GSM_MAX_RESPONSE_CHECKS
-#define TINY_GSM_MAX_RESPONSE_CHECKS 5
+#ifndef TINY_GSM_MAX_URCS
+// The maximum number of URCs in a module's URC table
+#define TINY_GSM_MAX_URCS 12
+#endif
+
+#ifndef TINY_GSM_MAX_USER_URCS
+// The maximum number of URC handlers that can be registered by the application
+#define TINY_GSM_MAX_USER_URCS 4
+#endif
+
+#ifndef TINY_GSM_AT_LINE_MAX
+// The longest command line the module accepts, not counting the "AT" or the
+// new line, when concatenating commands in a batch; 0 if the module doesn't
+// take concatenated commands
+#define TINY_GSM_AT_LINE_MAX 0
+#endif
+
+// The matcher slots waitResponse needs on top of the expected responses: the
+// two verbose error prefixes when debugging or keeping stats.  The URCs have a
+// matcher of their own, kept by the modem.
+#if defined TINY_GSM_DEBUG || defined TINY_GSM_STATS
+#define TINY_GSM_MATCHER_EXTRA_SLOTS 2
+#else
+#define TINY_GSM_MATCHER_EXTRA_SLOTS 0
 #endif
 
 #ifndef MODEM_MANUFACTURER
@@ -45,16 +75,184 @@
 #define MODEM_MODEL "unknown"
 #endif
 
+/**
+ * @brief A function registered by the application to handle an unsolicited
+ * result code.
+ *
+ * The function is called as soon as the text of the URC has been received.
+ * Anything after that text is still waiting in the stream and should be read
+ * out by the function - usually up to and including the next new line.
+ */
+typedef void (*TinyGsmUrcCallback)(Stream& stream);
+
+/**
+ * @brief One entry in a module's table of unsolicited result codes.
+ *
+ * Each module lists the URCs it can send in a table of these, ending with an
+ * entry with a null pattern.  The handler is called as soon as the received
+ * text ends with the pattern; it should read the rest of the URC from the
+ * stream and return true, or return false if the text was not that URC after
+ * all.
+ */
+template <class modemType>
+struct TinyGsmUrc {
+  GsmConstStr pattern;  ///< The text identifying the URC
+  bool (modemType::*handler)(TinyGsmResponse& data);  ///< The URC handler
+};
+
+// Check at compile time that a module's URC table, not counting the closing
+// null entry, fits in the slots the URC matcher sets aside for it
+#define TINY_GSM_CHECK_URC_TABLE(urcs)                                    \
+  static_assert(sizeof(urcs) / sizeof(urcs[0]) - 1 <= TINY_GSM_MAX_URCS, \
+                "The URC table has more entries than TINY_GSM_MAX_URCS")
+
 static const char GSM_AT[] TINY_GSM_PROGMEM = "AT";
 
 static const char GSM_OK[] TINY_GSM_PROGMEM    = AT_OK AT_NL;
 static const char GSM_ERROR[] TINY_GSM_PROGMEM = AT_ERROR AT_NL;
 
-#if defined TINY_GSM_DEBUG
+#if defined TINY_GSM_DEBUG || defined TINY_GSM_STATS
 static const char GSM_VERBOSE[] TINY_GSM_PROGMEM   = AT_VERBOSE;
 static const char GSM_VERBOSE_2[] TINY_GSM_PROGMEM = AT_VERBOSE_2;
 #endif
 
+class TinyGsmCommand;
+
+/**
+ * @brief A function called when a command sent with TinyGsmModem::submit()
+ * has finished.
+ */
+typedef void (*TinyGsmCommandCallback)(TinyGsmCommand& command);
+
+/**
+ * @brief An AT command that runs in the background.
+ *
+ * The command is handed to the modem with TinyGsmModem::submit() and moved
+ * along by TinyGsmModem::poll(), which doesn't wait for its response.  Once the
+ * command has finished, done() is true, result() gives the response that was
+ * received (just like the return of waitResponse) and response() holds the
+ * text received with it.  A callback can also be set to be called right away.
+ *
+ * A command without any command text sends nothing and just waits for its
+ * responses, like waitResponse().
+ *
+ * The command object must stay valid until it's done.
+ */
+class TinyGsmCommand {
+ public:
+  /**
+   * @param cmd The command, without the leading "AT"
+   * @param timeout_ms The time to wait for the response
+   */
+  explicit TinyGsmCommand(GsmConstStr cmd        = nullptr,
+                          uint32_t    timeout_ms = 1000L)
+      : _cmd(cmd),
+        _arg(nullptr),
+        _tail(nullptr),
+        _r1(GFP(GSM_OK)),
+        _r2(GFP(GSM_ERROR)),
+        _timeout_ms(timeout_ms),
+        _callback(nullptr),
+        _context(nullptr),
+        _next(nullptr),
+        _start(0),
+        _state(IDLE),
+        _result(0) {}
+
+  /**
+   * @brief Set the command to send
+   *
+   * @param cmd The command, without the leading "AT"
+   * @param arg Text from RAM to send after the command; optional
+   * @param tail Text to send after the argument; optional
+   * @param timeout_ms The time to wait for the response
+   */
+  void set(GsmConstStr cmd, const char* arg = nullptr,
+           GsmConstStr tail = nullptr, uint32_t timeout_ms = 1000L) {
+    _cmd        = cmd;
+    _arg        = arg;
+    _tail       = tail;
+    _timeout_ms = timeout_ms;
+  }
+
+  /**
+   * @brief Set the responses to wait for; by default "OK" and "ERROR"
+   */
+  void expect(GsmConstStr r1, GsmConstStr r2 = GFP(GSM_ERROR)) {
+    _r1 = r1;
+    _r2 = r2;
+  }
+
+  /**
+   * @brief Set a function to call once the command has finished
+   *
+   * @param callback The function
+   * @param context Anything the function needs; see context()
+   */
+  void onDone(TinyGsmCommandCallback callback, void* context = nullptr) {
+    _callback = callback;
+    _context  = context;
+  }
+
+  /**
+   * @brief Whether the command has been submitted and hasn't finished yet
+   */
+  bool pending() const {
+    return _state == QUEUED || _state == SENT;
+  }
+
+  /**
+   * @brief Whether the command has finished
+   */
+  bool done() const {
+    return _state == DONE;
+  }
+
+  /**
+   * @brief The (one based) index of the response received, or 0 if nothing
+   * matched before the timeout; only valid once done()
+   */
+  int8_t result() const {
+    return _result;
+  }
+
+  /**
+   * @brief The text received with the response; if it was longer than
+   * TINY_GSM_RESPONSE_BUFFER, only the end of it is kept.
+   */
+  TinyGsmResponse& response() {
+    return _data;
+  }
+
+  /**
+   * @brief The context given to onDone()
+   */
+  void* context() const {
+    return _context;
+  }
+
+ private:
+  template <class modemType>
+  friend class TinyGsmModem;
+
+  enum State : uint8_t { IDLE, QUEUED, SENT, DONE };
+
+  GsmConstStr            _cmd;
+  const char*            _arg;
+  GsmConstStr            _tail;
+  GsmConstStr            _r1;
+  GsmConstStr            _r2;
+  uint32_t               _timeout_ms;
+  TinyGsmCommandCallback _callback;
+  void*                  _context;
+  TinyGsmCommand*        _next;       ///< The command queued after this one
+  uint32_t               _start;      ///< When the command was sent
+  State                  _state;
+  int8_t                 _result;
+  TinyGsmResponse        _data;
+  TinyGsmMatcher<2 + TINY_GSM_MATCHER_EXTRA_SLOTS> _matcher;
+};
+
 template <class modemType>
 class TinyGsmModem {
   /* =========================================== */
@@ -95,11 +293,32 @@ class TinyGsmModem {
    */
   template <typename... Args>
   void sendAT(Args... cmd) {
+#ifdef TINY_GSM_STATS
+    statsBegin(cmd...);
+#endif
     thisModem().streamWrite(GFP(GSM_AT), cmd..., AT_NL);
     thisModem().stream.flush();
     TINY_GSM_YIELD(); /* DBG("### AT:", cmd...); */
   }
 
+  /**
+   * @brief Send a batch of AT commands and collect the result of each one
+   *
+   * The commands are run in order.  On modules that accept concatenated
+   * commands (TINY_GSM_AT_LINE_MAX > 0), consecutive commands that only expect
+   * "OK" are sent together on one command line and answered with a single
+   * response.  If such a line fails, its commands are run again one at a time
+   * to find out which one failed, so only use commands that can safely be
+   * repeated (ie, settings).
+   *
+   * @param batch The commands to send; the results are filled in
+   * @return *true* Every command got its expected response
+   * @return *false* A command failed or timed out
+   */
+  bool sendBatch(TinyGsmCommandBatch& batch) {
+    return thisModem().sendBatchImpl(batch);
+  }
+
   /**
    * @brief Set the module baud rate
    *
@@ -220,226 +439,84 @@ class TinyGsmModem {
   /**
    * @brief Listen for responses to commands and handle URCs
    *
+   * Any number of responses can be given; if none are given the defaults are
+   * "OK" and "ERROR", and if only one is given it is followed by "ERROR".
+   *
    * @param timeout_ms The time to wait for a response
    * @param data A string of data to fill in with response results
-   * @param r1 The first output to test against, optional with a default value
-   * of "OK"
-   * @param r2 The second output to test against, optional with a default value
-   * of "ERROR"
-   * @param r3 The third output to test against, optional with a default value
-   * of nullptr
-   * @param r4 The fourth output to test against, optional with a default value
-   * of nullptr
-   * @param r5 The fifth output to test against, optional with a default value
-   * of nullptr
-   * @param r6 The sixth output to test against, optional with a default value
-   * of nullptr
-   * @param r7 The seventh output to test against, optional with a default value
-   * of nullptr
-   * @return *int8_t* the index of the response input
+   * @param r1 The first output to test against
+   * @param r2 The second output to test against
+   * @param rest Any further outputs to test against
+   * @return *int8_t* the (one based) index of the matched response, or 0 if
+   * nothing matched before the timeout
+   *
+   * @note The response is collected in a fixed size TinyGsmResponse buffer;
+   * the String is only appended to when that overflows and once the wait
+   * finishes.
    */
-  int8_t waitResponse(uint32_t timeout_ms, String& data,
-                      GsmConstStr r1 = GFP(GSM_OK),
-                      GsmConstStr r2 = GFP(GSM_ERROR)
-#if TINY_GSM_MAX_RESPONSE_CHECKS > 2
-                          ,
-                      GsmConstStr r3 = nullptr
-#if TINY_GSM_MAX_RESPONSE_CHECKS > 3
-                      ,
-                      GsmConstStr r4 = nullptr
-#if TINY_GSM_MAX_RESPONSE_CHECKS > 4
-                      ,
-                      GsmConstStr r5 = nullptr
-#if TINY_GSM_MAX_RESPONSE_CHECKS > 5
-                      ,
-                      GsmConstStr r6 = nullptr
-#if TINY_GSM_MAX_RESPONSE_CHECKS > 6
-                      ,
-                      GsmConstStr r7 = nullptr
-#if TINY_GSM_MAX_RESPONSE_CHECKS > 7
-                      GsmConstStr r8 = nullptr
-#endif
-#endif
-#endif
-#endif
-#endif
-#endif
-  ) {
-    return thisModem().waitResponseImpl(timeout_ms, data, r1, r2
-#if TINY_GSM_MAX_RESPONSE_CHECKS > 2
-                                        ,
-                                        r3
-#if TINY_GSM_MAX_RESPONSE_CHECKS > 3
-                                        ,
-                                        r4
-#if TINY_GSM_MAX_RESPONSE_CHECKS > 4
-                                        ,
-                                        r5
-#if TINY_GSM_MAX_RESPONSE_CHECKS > 5
-                                        ,
-                                        r6
-#if TINY_GSM_MAX_RESPONSE_CHECKS > 6
-                                        ,
-                                        r7
-#if TINY_GSM_MAX_RESPONSE_CHECKS > 7
-                                        ,
-                                        r8
-#endif
-#endif
-#endif
-#endif
-#endif
-#endif
-    );
+  template <typename... Rest>
+  int8_t waitResponse(uint32_t timeout_ms, String& data, GsmConstStr r1,
+                      GsmConstStr r2, Rest... rest) {
+    TinyGsmResponse buffer(&data);
+    int8_t index = waitResponseFor(timeout_ms, buffer, r1, r2, rest...);
+    buffer.flushToSink();
+    return index;
+  }
+  int8_t waitResponse(uint32_t timeout_ms, String& data, GsmConstStr r1) {
+    return waitResponse(timeout_ms, data, r1, GFP(GSM_ERROR));
+  }
+  int8_t waitResponse(uint32_t timeout_ms, String& data) {
+    return waitResponse(timeout_ms, data, GFP(GSM_OK), GFP(GSM_ERROR));
   }
 
   /**
    * @brief Listen for responses to commands and handle URCs
    *
+   * Any number of responses can be given; if none are given the defaults are
+   * "OK" and "ERROR", and if only one is given it is followed by "ERROR".
+   *
    * @param timeout_ms The time to wait for a response
-   * @param r1 The first output to test against, optional with a default value
-   * of "OK"
-   * @param r2 The second output to test against, optional with a default value
-   * of "ERROR"
-   * @param r3 The third output to test against, optional with a default value
-   * of nullptr
-   * @param r4 The fourth output to test against, optional with a default value
-   * of nullptr
-   * @param r5 The fifth output to test against, optional with a default value
-   * of nullptr
-   * @param r6 The sixth output to test against, optional with a default value
-   * of nullptr
-   * @param r7 The seventh output to test against, optional with a default value
-   * of nullptr
-   * @return *int8_t* the index of the response input
+   * @param r1 The first output to test against
+   * @param r2 The second output to test against
+   * @param rest Any further outputs to test against
+   * @return *int8_t* the (one based) index of the matched response, or 0 if
+   * nothing matched before the timeout
    */
-  int8_t waitResponse(uint32_t timeout_ms, GsmConstStr r1 = GFP(GSM_OK),
-                      GsmConstStr r2 = GFP(GSM_ERROR)
-#if TINY_GSM_MAX_RESPONSE_CHECKS > 2
-                          ,
-                      GsmConstStr r3 = nullptr
-#if TINY_GSM_MAX_RESPONSE_CHECKS > 3
-                      ,
-                      GsmConstStr r4 = nullptr
-#if TINY_GSM_MAX_RESPONSE_CHECKS > 4
-                      ,
-                      GsmConstStr r5 = nullptr
-#if TINY_GSM_MAX_RESPONSE_CHECKS > 5
-                      ,
-                      GsmConstStr r6 = nullptr
-#if TINY_GSM_MAX_RESPONSE_CHECKS > 6
-                      ,
-                      GsmConstStr r7 = nullptr
-#if TINY_GSM_MAX_RESPONSE_CHECKS > 7
-                      GsmConstStr r8 = nullptr
-#endif
-#endif
-#endif
-#endif
-#endif
-#endif
-  ) {
-    String data;
-    return waitResponse(timeout_ms, data, r1, r2
-#if TINY_GSM_MAX_RESPONSE_CHECKS > 2
-                        ,
-                        r3
-#if TINY_GSM_MAX_RESPONSE_CHECKS > 3
-                        ,
-                        r4
-#if TINY_GSM_MAX_RESPONSE_CHECKS > 4
-                        ,
-                        r5
-#if TINY_GSM_MAX_RESPONSE_CHECKS > 5
-                        ,
-                        r6
-#if TINY_GSM_MAX_RESPONSE_CHECKS > 6
-                        ,
-                        r7
-#if TINY_GSM_MAX_RESPONSE_CHECKS > 7
-                        ,
-                        r8
-#endif
-#endif
-#endif
-#endif
-#endif
-#endif
-    );
+  template <typename... Rest>
+  int8_t waitResponse(uint32_t timeout_ms, GsmConstStr r1, GsmConstStr r2,
+                      Rest... rest) {
+    TinyGsmResponse data;
+    return waitResponseFor(timeout_ms, data, r1, r2, rest...);
+  }
+  int8_t waitResponse(uint32_t timeout_ms, GsmConstStr r1) {
+    return waitResponse(timeout_ms, r1, GFP(GSM_ERROR));
+  }
+  int8_t waitResponse(uint32_t timeout_ms) {
+    return waitResponse(timeout_ms, GFP(GSM_OK), GFP(GSM_ERROR));
   }
 
   /**
    * @brief Listen for responses to commands and handle URCs; listening for 1
    * second.
    *
-   * @param r1 The first output to test against, optional with a default value
-   * of "OK"
-   * @param r2 The second output to test against, optional with a default value
-   * of "ERROR"
-   * @param r3 The third output to test against, optional with a default value
-   * of nullptr
-   * @param r4 The fourth output to test against, optional with a default value
-   * of nullptr
-   * @param r5 The fifth output to test against, optional with a default value
-   * of nullptr
-   * @param r6 The sixth output to test against, optional with a default value
-   * of nullptr
-   * @param r7 The seventh output to test against, optional with a default value
-   * of nullptr
-   * @return *int8_t* the index of the response input
+   * Any number of responses can be given; if none are given the defaults are
+   * "OK" and "ERROR", and if only one is given it is followed by "ERROR".
+   *
+   * @param r1 The first output to test against
+   * @param r2 The second output to test against
+   * @param rest Any further outputs to test against
+   * @return *int8_t* the (one based) index of the matched response, or 0 if
+   * nothing matched before the timeout
    */
-  int8_t waitResponse(GsmConstStr r1 = GFP(GSM_OK),
-                      GsmConstStr r2 = GFP(GSM_ERROR)
-#if TINY_GSM_MAX_RESPONSE_CHECKS > 2
-                          ,
-                      GsmConstStr r3 = nullptr
-#if TINY_GSM_MAX_RESPONSE_CHECKS > 3
-                      ,
-                      GsmConstStr r4 = nullptr
-#if TINY_GSM_MAX_RESPONSE_CHECKS > 4
-                      ,
-                      GsmConstStr r5 = nullptr
-#if TINY_GSM_MAX_RESPONSE_CHECKS > 5
-                      ,
-                      GsmConstStr r6 = nullptr
-#if TINY_GSM_MAX_RESPONSE_CHECKS > 6
-                      ,
-                      GsmConstStr r7 = nullptr
-#if TINY_GSM_MAX_RESPONSE_CHECKS > 7
-                      GsmConstStr r8 = nullptr
-#endif
-#endif
-#endif
-#endif
-#endif
-#endif
-  ) {
-    return waitResponse(1000L, r1, r2
-#if TINY_GSM_MAX_RESPONSE_CHECKS > 2
-                        ,
-                        r3
-#if TINY_GSM_MAX_RESPONSE_CHECKS > 3
-                        ,
-                        r4
-#if TINY_GSM_MAX_RESPONSE_CHECKS > 4
-                        ,
-                        r5
-#if TINY_GSM_MAX_RESPONSE_CHECKS > 5
-                        ,
-                        r6
-#if TINY_GSM_MAX_RESPONSE_CHECKS > 6
-                        ,
-                        r7
-#if TINY_GSM_MAX_RESPONSE_CHECKS > 7
-                        ,
-                        r8
-#endif
-#endif
-#endif
-#endif
-#endif
-#endif
-    );
+  template <typename... Rest>
+  int8_t waitResponse(GsmConstStr r1, GsmConstStr r2, Rest... rest) {
+    return waitResponse(1000L, r1, r2, rest...);
+  }
+  int8_t waitResponse(GsmConstStr r1) {
+    return waitResponse(1000L, r1, GFP(GSM_ERROR));
+  }
+  int8_t waitResponse() {
+    return waitResponse(1000L, GFP(GSM_OK), GFP(GSM_ERROR));
   }
 
   /**
@@ -647,6 +724,227 @@ class TinyGsmModem {
   }
   /**@}*/
 
+  /**
+   * @anchor urc_functions
+   * @name Unsolicited Result Codes
+   */
+  /**@{*/
+
+  /**
+   * @brief Register a function to handle an unsolicited result code that
+   * isn't already handled by the library, e.g. "+CMTI:" for an incoming SMS.
+   *
+   * The URCs handled by the module itself take precedence over any registered
+   * here.
+   *
+   * @param pattern The text identifying the URC; this must stay valid, so use
+   * a literal or a flash string (GF("+CMTI:"))
+   * @param callback The function to call when the URC is received
+   * @return *true* The handler was registered
+   * @return *false* There's no room left for another handler; increase
+   * TINY_GSM_MAX_USER_URCS
+   */
+  bool registerURC(GsmConstStr pattern, TinyGsmUrcCallback callback) {
+    if (!pattern || !callback) { return false; }
+    for (uint8_t i = 0; i < userUrcCount; i++) {
+      if (samePattern(userUrcPatterns[i], pattern)) {
+        userUrcCallbacks[i] = callback;
+        return true;
+      }
+    }
+    if (userUrcCount >= TINY_GSM_MAX_USER_URCS) { return false; }
+    userUrcPatterns[userUrcCount]  = pattern;
+    userUrcCallbacks[userUrcCount] = callback;
+    userUrcCount++;
+    urcMatcherReady = false;
+    return true;
+  }
+
+  /**
+   * @brief Remove a URC handler registered with registerURC().
+   *
+   * @param pattern The text of the pattern used to register the handler
+   * @return *true* The handler was removed
+   * @return *false* No handler was registered for the pattern
+   */
+  bool unregisterURC(GsmConstStr pattern) {
+    for (uint8_t i = 0; i < userUrcCount; i++) {
+      if (samePattern(userUrcPatterns[i], pattern)) {
+        userUrcCount--;
+        for (; i < userUrcCount; i++) {
+          userUrcPatterns[i]  = userUrcPatterns[i + 1];
+          userUrcCallbacks[i] = userUrcCallbacks[i + 1];
+        }
+        urcMatcherReady = false;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * @brief Check if the received text ends with a known URC and handle it if
+   * it does.
+   *
+   * This is done for every received character while waiting for a response;
+   * it is only exposed for custom response handling.
+   *
+   * @param data The text received so far
+   * @return *true* A URC was handled and the data should be discarded
+   * @return *false* The data doesn't end with a URC
+   */
+  bool handleURCs(TinyGsmResponse& data) {
+    uint8_t slot = 0;
+    for (const TinyGsmUrc<modemType>* urc = thisModem().getURCTableImpl();
+         urc->pattern; urc++, slot++) {
+      if (data.endsWith(urc->pattern)) { return handleURC(slot, data); }
+    }
+    for (uint8_t i = 0; i < userUrcCount; i++) {
+      if (data.endsWith(userUrcPatterns[i])) {
+        return handleURC(slot + i, data);
+      }
+    }
+    return false;
+  }
+  /**@}*/
+
+  /**
+   * @anchor async_functions
+   * @name Background Commands
+   */
+  /**@{*/
+
+  /**
+   * @brief Queue a command to run in the background
+   *
+   * The command is sent and its response collected by poll(); commands
+   * submitted while another is running are sent in order once it finishes.
+   *
+   * @warning Don't call any of the other modem functions while a command is
+   * running in the background (see busy()), they would take its response.
+   *
+   * @param command The command; it must stay valid until it's done
+   * @return *true* The command was queued
+   * @return *false* The command is already pending
+   */
+  bool submit(TinyGsmCommand& command) {
+    if (command.pending()) { return false; }
+    command._state  = TinyGsmCommand::QUEUED;
+    command._result = 0;
+    command._next   = nullptr;
+    command._data.clear();
+    TinyGsmCommand** tail = &commandQueue;
+    while (*tail) { tail = &(*tail)->_next; }
+    *tail = &command;
+    return true;
+  }
+
+  /**
+   * @brief Move the background commands along without waiting for their
+   * responses
+   *
+   * Call this as often as possible from the main loop.  It sends the next
+   * queued command, works through whatever the modem has sent so far and
+   * finishes the command once its response has been received or it has timed
+   * out.
+   *
+   * @note poll() itself doesn't wait for the modem, but it runs the handler
+   * of any URC it receives, and those can block: they read the rest of the
+   * URC from the stream, which waits up to the stream's timeout if it hasn't
+   * all arrived yet, and the A7672x's secure data handler sends an AT command
+   * of its own and waits up to 2 seconds for the answer.  A registered URC
+   * callback is run the same way, so keep those short.
+   *
+   * @return *true* There are still commands running or queued
+   * @return *false* There's nothing left to do
+   */
+  bool poll() {
+    TinyGsmCommand* c = commandQueue;
+    if (!c) { return false; }
+    if (c->_state == TinyGsmCommand::QUEUED) {
+      if (c->_cmd) {
+#ifdef TINY_GSM_STATS
+        statsBegin(c->_cmd);
+#endif
+        thisModem().stream.print(GFP(GSM_AT));
+        thisModem().stream.print(c->_cmd);
+        if (c->_arg) { thisModem().stream.print(c->_arg); }
+        if (c->_tail) { thisModem().stream.print(c->_tail); }
+        thisModem().stream.print(AT_NL);
+        thisModem().stream.flush();
+      }
+      c->_matcher.clear();
+      c->_matcher.add(c->_r1);
+      c->_matcher.add(c->_r2);
+      prepareMatcher(c->_matcher, 2);
+      c->_start = millis();
+      c->_state     = TinyGsmCommand::SENT;
+    }
+    while (thisModem().stream.fill() > 0) {
+      int8_t a = thisModem().stream.read();
+      if (a <= 0) continue;  // Skip 0x00 bytes, just in case
+      int8_t index = checkResponse(static_cast<char>(a), c->_data, c->_matcher,
+                                   2);
+      if (index) {
+        finishCommand(*c, index);
+        return commandQueue != nullptr;
+      }
+    }
+    if (millis() - c->_start >= c->_timeout_ms) { finishCommand(*c, 0); }
+    return commandQueue != nullptr;
+  }
+
+  /**
+   * @brief Whether any command submitted to run in the background hasn't
+   * finished yet
+   */
+  bool busy() const {
+    return commandQueue != nullptr;
+  }
+  /**@}*/
+
+#ifdef TINY_GSM_STATS
+  /**
+   * @anchor stats_functions
+   * @name Statistics
+   *
+   * Only available when TINY_GSM_STATS is defined before including the
+   * library.
+   */
+  /**@{*/
+
+  /**
+   * @brief The latency, timeouts and errors of each AT command sent so far,
+   * and the number of characters that went each way
+   *
+   * The command currently being timed is counted as finished.
+   */
+  const TinyGsmStats& getStats() {
+    stats.end();
+    stats.rx_bytes = thisModem().stream.received();
+    stats.tx_bytes = thisModem().stream.sent();
+    return stats;
+  }
+
+  /**
+   * @brief Print a table of the statistics collected so far
+   *
+   * @param out Where to print it; ie, Serial
+   */
+  void dumpStats(Print& out) {
+    getStats().dump(out);
+  }
+
+  /**
+   * @brief Forget the statistics collected so far
+   */
+  void resetStats() {
+    stats.reset();
+    thisModem().stream.resetCounts();
+  }
+  /**@}*/
+#endif
+
   /**
    * @anchor crtp_helper
    * @name CRTP Helper
@@ -662,6 +960,18 @@ class TinyGsmModem {
   /**@}*/
   ~TinyGsmModem() {}
 
+  GsmConstStr        userUrcPatterns[TINY_GSM_MAX_USER_URCS];
+  TinyGsmUrcCallback userUrcCallbacks[TINY_GSM_MAX_USER_URCS];
+  uint8_t            userUrcCount = 0;
+  TinyGsmCommand*    commandQueue = nullptr;
+  // The module's URCs and then the application's, shared by every wait for a
+  // response; built on first use and again after the application's change
+  TinyGsmMatcher<TINY_GSM_MAX_URCS + TINY_GSM_MAX_USER_URCS> urcMatcher;
+  bool urcMatcherReady = false;
+#ifdef TINY_GSM_STATS
+  TinyGsmStats stats;
+#endif
+
 
   /**
    * @anchor modem_utilities
@@ -757,6 +1067,11 @@ class TinyGsmModem {
     return -9999.0F;
   }
 
+  // Read the rest of a response line and split it into fields
+  inline uint8_t streamGetFields(TinyGsmFieldList& fields, char sep = ',') {
+    return fields.read(thisModem().stream, sep);
+  }
+
   inline bool streamSkipUntil(const char c, const uint32_t timeout_ms = 1000L) {
     uint32_t startMillis = millis();
     while (millis() - startMillis < timeout_ms) {
@@ -769,6 +1084,71 @@ class TinyGsmModem {
     return false;
   }
 
+  // Wait for any of the given responses; the matcher is sized at compile time
+  // to fit exactly these responses plus the verbose errors
+  template <typename... Responses>
+  int8_t waitResponseFor(uint32_t timeout_ms, TinyGsmResponse& data,
+                         Responses... responses) {
+    const GsmConstStr list[] = {responses...};
+    TinyGsmMatcher<sizeof...(Responses) + TINY_GSM_MATCHER_EXTRA_SLOTS>
+        matcher;
+    for (uint8_t i = 0; i < sizeof...(Responses); i++) { matcher.add(list[i]); }
+    return thisModem().waitResponseImpl(timeout_ms, data, matcher,
+                                        sizeof...(Responses));
+  }
+
+  // Add the module's URCs and then the application's to a matcher, in slot
+  // order; returns false if the matcher ran out of room, in which case the
+  // URCs that didn't fit will be missed
+  bool addURCsToMatcher(TinyGsmPatternMatcher& matcher) {
+    bool fit = true;
+    for (const TinyGsmUrc<modemType>* urc = thisModem().getURCTableImpl();
+         urc->pattern; urc++) {
+      if (!matcher.add(urc->pattern)) { fit = false; }
+    }
+    for (uint8_t i = 0; i < userUrcCount; i++) {
+      if (!matcher.add(userUrcPatterns[i])) { fit = false; }
+    }
+    if (!fit) { DBG(GF("### No room in the matcher for every URC")); }
+    return fit;
+  }
+
+  // Run the handler for a URC slot; the module's URCs come first, followed by
+  // those registered by the application
+  bool handleURC(uint8_t slot, TinyGsmResponse& data) {
+    const TinyGsmUrc<modemType>* urc = thisModem().getURCTableImpl();
+    for (; urc->pattern; urc++, slot--) {
+      if (slot == 0) {
+#ifdef TINY_GSM_DEBUG_DEEP
+        DBG(GF("### URC:"), urc->pattern);
+#endif
+        return (thisModem().*(urc->handler))(data);
+      }
+    }
+    if (slot < userUrcCount) {
+      userUrcCallbacks[slot](thisModem().stream);
+      return true;
+    }
+    return false;
+  }
+
+  // Compare two patterns by their text; the same flash string written out in
+  // two places doesn't have the same address.
+  static bool samePattern(GsmConstStr a, GsmConstStr b) {
+    for (size_t i = 0; TINY_GSM_PGM_CHAR(a, i) == TINY_GSM_PGM_CHAR(b, i);
+         i++) {
+      if (TINY_GSM_PGM_CHAR(a, i) == '\0') { return true; }
+    }
+    return false;
+  }
+
+  // A URC handler for notifications that need no action; throws away the rest
+  // of the line
+  bool handleURCSkipLine(TinyGsmResponse&) {
+    thisModem().streamSkipUntil('\n');
+    return true;
+  }
+
   inline void cleanResponseString(String& res) {
     // Remove the OK from the string, as well as any newlines
     res.replace(AT_NL "OK" AT_NL, "");
@@ -815,6 +1195,60 @@ class TinyGsmModem {
     return thisModem().waitResponse() == 1;
   }
 
+  bool sendBatchImpl(TinyGsmCommandBatch& batch) {
+    for (uint8_t i = 0; i < batch.count(); i++) { batch[i].result = -1; }
+    bool    success    = true;
+    uint8_t solo_until = 0;  // run the commands before this one at a time
+    uint8_t i          = 0;
+    while (i < batch.count()) {
+      // put as many of the following commands onto the line as will fit
+      uint8_t  end     = i + 1;
+      uint32_t timeout = batch[i].timeout_ms;
+      if (i >= solo_until && batch.chainable(i)) {
+        size_t len = batch.length(i);
+        while (end < batch.count() && batch.chainable(end) &&
+               len + 1 + batch.length(end) <= TINY_GSM_AT_LINE_MAX) {
+          len += 1 + batch.length(end);
+          timeout += batch[end].timeout_ms;
+          end++;
+        }
+      }
+
+#ifdef TINY_GSM_STATS
+      // the whole line is timed under its first command
+      statsBegin(batch[i].cmd);
+#endif
+      thisModem().stream.print(GFP(GSM_AT));
+      for (uint8_t j = i; j < end; j++) {
+        if (j > i) { thisModem().stream.print(';'); }
+        if (batch[j].cmd) { thisModem().stream.print(batch[j].cmd); }
+        if (batch[j].arg) { thisModem().stream.print(batch[j].arg); }
+        if (batch[j].tail) { thisModem().stream.print(batch[j].tail); }
+      }
+      thisModem().stream.print(AT_NL);
+      thisModem().stream.flush();
+      TINY_GSM_YIELD();
+
+      GsmConstStr expected = batch[i].response ? batch[i].response
+                                               : GFP(GSM_OK);
+      int8_t      res = thisModem().waitResponse(timeout, expected,
+                                                 GFP(GSM_ERROR));
+      if (res != 1 && end - i > 1) {
+        // the module stops at the first command on the line that fails, so
+        // the earlier ones may have worked; go back and find out which
+        solo_until = end;
+        continue;
+      }
+      for (uint8_t j = i; j < end; j++) { batch[j].result = res; }
+      i = end;
+      if (res != 1) {
+        success = false;
+        if (batch.stopOnError()) { break; }
+      }
+    }
+    return success;
+  }
+
   bool testATImpl(uint32_t timeout_ms) {
     for (uint32_t start = millis(); millis() - start < timeout_ms;) {
       thisModem().sendAT(GF(""));
@@ -824,140 +1258,190 @@ class TinyGsmModem {
     return false;
   }
 
-  int8_t waitResponseImpl(uint32_t timeout_ms, String& data, GsmConstStr r1,
-                          GsmConstStr r2
-#if TINY_GSM_MAX_RESPONSE_CHECKS > 2
-                          ,
-                          GsmConstStr r3
-#if TINY_GSM_MAX_RESPONSE_CHECKS > 3
-                          ,
-                          GsmConstStr r4
-#if TINY_GSM_MAX_RESPONSE_CHECKS > 4
-                          ,
-                          GsmConstStr r5
-#if TINY_GSM_MAX_RESPONSE_CHECKS > 5
-                          ,
-                          GsmConstStr r6
-#if TINY_GSM_MAX_RESPONSE_CHECKS > 6
-                          ,
-                          GsmConstStr r7
-#if TINY_GSM_MAX_RESPONSE_CHECKS > 7
-                          ,
-                          GsmConstStr r8
-#endif
-#endif
-#endif
-#endif
-#endif
-#endif
-  ) {
-    data.reserve(64);
-
-    // put the possible responses into an array so we can loop through them
-    const GsmConstStr responses[TINY_GSM_MAX_RESPONSE_CHECKS] = {r1,
-                                                                 r2
-#if TINY_GSM_MAX_RESPONSE_CHECKS > 2
-                                                                 ,
-                                                                 r3
-#if TINY_GSM_MAX_RESPONSE_CHECKS > 3
-                                                                 ,
-                                                                 r4
-#if TINY_GSM_MAX_RESPONSE_CHECKS > 4
-                                                                 ,
-                                                                 r5
-#if TINY_GSM_MAX_RESPONSE_CHECKS > 5
-                                                                 ,
-                                                                 r6
-#if TINY_GSM_MAX_RESPONSE_CHECKS > 6
-                                                                 ,
-                                                                 r7
-#if TINY_GSM_MAX_RESPONSE_CHECKS > 7
-                                                                 ,
-                                                                 r8
-#endif
-#endif
-#endif
-#endif
-#endif
-#endif
-    };
-
-#ifdef TINY_GSM_DEBUG_DEEP
-    DBG(GF("r1 <"), r1 ? r1 : GF("NULL"), GF("> r2 <"), r2 ? r2 : GF("NULL"),
-#if TINY_GSM_MAX_RESPONSE_CHECKS > 2
-        GF("> r3 <"), r3 ? r3 : GF("NULL"),
-#if TINY_GSM_MAX_RESPONSE_CHECKS > 3
-        GF("> r4 <"), r4 ? r4 : GF("NULL"),
-#if TINY_GSM_MAX_RESPONSE_CHECKS > 4
-        GF("> r5 <"), r5 ? r5 : GF("NULL"),
-#if TINY_GSM_MAX_RESPONSE_CHECKS > 5
-        GF("> r6 <"), r6 ? r6 : GF("NULL"),
-#if TINY_GSM_MAX_RESPONSE_CHECKS > 6
-        GF("> r7 <"), r7 ? r7 : GF("NULL"),
-#if TINY_GSM_MAX_RESPONSE_CHECKS > 7
-        GF("> r8 <"), r8 ? r8 : GF("NULL"),
-#endif
-#endif
-#endif
-#endif
-#endif
-#endif
-        '>');
-#endif
-    uint8_t  index       = 0;
+  int8_t waitResponseImpl(uint32_t timeout_ms, TinyGsmResponse& data,
+                          TinyGsmPatternMatcher& matcher, uint8_t count) {
+    prepareMatcher(matcher, count);
+    int8_t   index       = 0;
     uint32_t startMillis = millis();
     do {
       TINY_GSM_YIELD();
-      while (thisModem().stream.available() > 0) {
-        TINY_GSM_YIELD();
+      // Pull everything that's ready from the stream in one block and work
+      // through it without yielding; anything left over after a match stays
+      // in the block for the next read.
+      while (thisModem().stream.fill() > 0) {
         int8_t a = thisModem().stream.read();
         if (a <= 0) continue;  // Skip 0x00 bytes, just in case
-        data += static_cast<char>(a);
-        // loop through the possible responses and see if we have a match
-        for (uint8_t i = 0; i < TINY_GSM_MAX_RESPONSE_CHECKS; i++) {
-          if (responses[i] && data.endsWith(responses[i])) {
-            index = i + 1;
-            goto finish;
-          }
-        }
-#if defined TINY_GSM_DEBUG
-        if ((data.endsWith(GFP(GSM_VERBOSE))) ||
-            (data.endsWith(GFP(GSM_VERBOSE_2)))) {
-          // check how long the new line is
-          // should be either 1 ('\r' or '\n') or 2 ("\r\n"))
-          const int  len_atnl    = strnlen(AT_NL, 3);
-          const char last_atnl_c = len_atnl > 0 ? AT_NL[len_atnl - 1] : '\n';
-          // Read out the verbose message, until the last character of the new
-          // line
-          data += thisModem().stream.readStringUntil(last_atnl_c);
-#ifdef TINY_GSM_DEBUG_DEEP
-          data.trim();
-          DBG(GF("Verbose details <<<"), data, GF(">>>"));
-#endif
-          data = "";
-          goto finish;
-        }
-#endif
-        if (thisModem().handleURCs(data)) { data = ""; }
+        index = checkResponse(static_cast<char>(a), data, matcher, count);
+        if (index) { goto finish; }
+        if (!thisModem().stream.buffered()) { TINY_GSM_YIELD(); }
       }
     } while (millis() - startMillis < timeout_ms);
   finish:
+#ifdef TINY_GSM_STATS
+    statsResponse(matcher, index);
+#endif
+    if (index < 0) { index = 0; }
+    finishResponse(index, data);
+    return index;
+  }
+
+  // Add the verbose errors to a matcher holding the expected responses, and
+  // get the URC matcher ready to start a new wait
+  void prepareMatcher(TinyGsmPatternMatcher& matcher, uint8_t count) {
+#if defined TINY_GSM_DEBUG || defined TINY_GSM_STATS
+    // the verbose error prefixes go after the expected responses so the
+    // responses still win if both match on the same character
+    matcher.add(GFP(GSM_VERBOSE));
+    matcher.add(GFP(GSM_VERBOSE_2));
+#endif
+    // the URCs rarely change, so their fall back tables are only worked out
+    // again when they do
+    if (!urcMatcherReady) {
+      urcMatcher.clear();
+      addURCsToMatcher(urcMatcher);
+      urcMatcherReady = true;
+    }
+    urcMatcher.reset();
+
 #ifdef TINY_GSM_DEBUG_DEEP
-    data.replace("\r", "←");
-    data.replace("\n", "↓");
+    for (uint8_t i = 1; i <= count; i++) {
+      GsmConstStr r = matcher.pattern(i);
+      DBG(GF("r"), i, GF(" <"), r ? r : GF("NULL"), '>');
+    }
+#else
+    (void)count;
+#endif
+  }
+
+  // Take in one received character while waiting for a response; returns the
+  // index of the response once one has been received, -1 if the wait ended
+  // without one (a verbose error) or 0 to keep waiting
+  int8_t checkResponse(char c, TinyGsmResponse& data,
+                       TinyGsmPatternMatcher& matcher, uint8_t count) {
+    data += c;
+    // both matchers see every character, so neither loses its place
+    int8_t hit     = matcher.step(c);
+    int8_t urc_hit = urcMatcher.step(c);
+    if (hit > 0 && hit <= count) { return hit; }
+#if defined TINY_GSM_DEBUG || defined TINY_GSM_STATS
+    if (hit > count) {
+      // check how long the new line is
+      // should be either 1 ('\r' or '\n') or 2 ("\r\n"))
+      const int  len_atnl    = strnlen(AT_NL, 3);
+      const char last_atnl_c = len_atnl > 0 ? AT_NL[len_atnl - 1] : '\n';
+      // Read out the verbose message, until the last character of the new
+      // line
+#ifdef TINY_GSM_DEBUG_DEEP
+      String verbose = data.c_str();
+      verbose += thisModem().stream.readStringUntil(last_atnl_c);
+      verbose.trim();
+      DBG(GF("Verbose details <<<"), verbose, GF(">>>"));
+#else
+      thisModem().streamSkipUntil(last_atnl_c);
 #endif
+      data = "";
+      return -1;
+    }
+#endif
+    if (urc_hit && handleURC(urc_hit - 1, data)) { data = ""; }
+    // the responses can only match text received after a handled URC
+    if (!data.length()) {
+      matcher.reset();
+      urcMatcher.reset();
+    }
+    return 0;
+  }
+
+  // Tidy up the received text once the wait for a response is over
+  void finishResponse(int8_t index, TinyGsmResponse& data) {
     if (!index) {
       data.trim();
-      if (data.length()) { DBG("### Unhandled:", data); }
+      if (data.length()) { DBG("### Unhandled:", data.c_str()); }
       data = "";
     } else {
 #ifdef TINY_GSM_DEBUG_DEEP
-      DBG('<', index, '>', data);
+      String shown = data.c_str();
+      shown.replace("\r", "←");
+      shown.replace("\n", "↓");
+      DBG('<', index, '>', shown);
 #endif
     }
-    return index;
   }
 
+  // Finish the command at the head of the background queue and start on the
+  // next one
+  void finishCommand(TinyGsmCommand& command, int8_t index) {
+#ifdef TINY_GSM_STATS
+    statsResponse(command._matcher, index);
+#endif
+    if (index < 0) { index = 0; }
+    finishResponse(index, command._data);
+    commandQueue    = command._next;
+    command._next   = nullptr;
+    command._result = index;
+    command._state  = TinyGsmCommand::DONE;
+    if (command._callback) { command._callback(command); }
+  }
+
+#ifdef TINY_GSM_STATS
+  // Start timing a command, named after the start of the text sent for it
+  template <typename... Args>
+  void statsBegin(Args... cmd) {
+    char    name[TINY_GSM_STATS_PREFIX + 1];
+    uint8_t len = 0;
+    statsName(name, len, cmd...);
+    if (!len) { strcpy(name, "AT"); }  // a bare "AT"
+    stats.begin(name, millis());
+  }
+
+  // Collect the command name from the pieces of the command, up to the first
+  // '=', '?' or ';' (or an argument that isn't text)
+  template <typename T, typename... Args>
+  static bool statsName(char* name, uint8_t& len, T head, Args... tail) {
+    return statsName(name, len, head) && statsName(name, len, tail...);
+  }
+  static bool statsName(char* name, uint8_t& len) {
+    name[len] = '\0';
+    return true;
+  }
+  static bool statsName(char* name, uint8_t& len, char c) {
+    if (c == '=' || c == '?' || c == ';' || len >= TINY_GSM_STATS_PREFIX) {
+      name[len] = '\0';
+      return false;
+    }
+    name[len++] = c;
+    name[len]   = '\0';
+    return true;
+  }
+  static bool statsName(char* name, uint8_t& len, const char* s) {
+    if (!s) { return statsName(name, len); }
+    for (; *s; s++) {
+      if (!statsName(name, len, *s)) { return false; }
+    }
+    return true;
+  }
+  static bool statsName(char* name, uint8_t& len,
+                        const __FlashStringHelper* s) {
+    if (!s) { return statsName(name, len); }
+    for (uint8_t i = 0; TINY_GSM_PGM_CHAR(s, i); i++) {
+      if (!statsName(name, len, TINY_GSM_PGM_CHAR(s, i))) { return false; }
+    }
+    return true;
+  }
+  template <typename T>
+  static bool statsName(char* name, uint8_t& len, T) {
+    name[len] = '\0';
+    return false;
+  }
+
+  // Count the end of a wait for a response to the command being timed
+  void statsResponse(TinyGsmPatternMatcher& matcher, int8_t index) {
+    stats.response(millis(), index == 0,
+                   index > 0 && matcher.pattern(index) == GFP(GSM_ERROR),
+                   index < 0);
+  }
+#endif
+
 
   String getModemInfoImpl() {
     thisModem().sendAT('I');  // 3GPP TS 27.007
@@ -0,0 +1,259 @@
+/**
+ * @file       TinyGsmResponseBuffer.h
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ */
+
+#ifndef SRC_TINYGSMRESPONSEBUFFER_H_
+#define SRC_TINYGSMRESPONSEBUFFER_H_
+
+#include "TinyGsmCommon.h"
+
+/**
+ * @brief A fixed size, linear buffer for collecting responses from the modem.
+ *
+ * This replaces the heap allocated String that used to be used to accumulate
+ * the modem response while waiting for it to match one of the expected
+ * responses.  The buffer never allocates.
+ *
+ * All of the response and URC matching is done against the *end* of the
+ * buffer, so when the buffer fills the oldest half of the content is dropped
+ * to make room.  If an overflow sink String has been attached, the dropped
+ * characters are appended to it instead of being discarded.  The String
+ * versions of waitResponse use this to keep handing back the full text of the
+ * response.
+ *
+ * @tparam N The maximum number of characters held in the buffer
+ */
+template <size_t N>
+class TinyGsmResponseBuffer {
+ public:
+  /**
+   * @brief Construct a new, empty response buffer with no overflow sink
+   */
+  TinyGsmResponseBuffer() {
+    clear();
+  }
+
+  /**
+   * @brief Construct a new, empty response buffer
+   *
+   * @param sink A String to move the oldest characters into when the buffer
+   * overflows. The sink is *not* cleared on construction.
+   */
+  explicit TinyGsmResponseBuffer(String* sink) : _sink(sink) {
+    _len  = 0;
+    _b[0] = '\0';
+  }
+
+  /**
+   * @brief Empty the buffer and the overflow sink, if there is one
+   */
+  void clear() {
+    _len  = 0;
+    _b[0] = '\0';
+    if (_sink) { *_sink = ""; }
+  }
+
+  /**
+   * @brief Add a single character to the end of the buffer, making room if
+   * needed
+   *
+   * @param c The character to add
+   */
+  void push(char c) {
+    if (_len >= N) { overflow(); }
+    _b[_len++] = c;
+    _b[_len]   = '\0';
+  }
+
+  TinyGsmResponseBuffer& operator+=(char c) {
+    push(c);
+    return *this;
+  }
+
+  /**
+   * @brief Add the decimal representation of an integer to the buffer
+   *
+   * @param v The value to add
+   */
+  TinyGsmResponseBuffer& operator+=(int v) {
+    char          digits[10];
+    uint8_t       n = 0;
+    unsigned long u = v < 0 ? -static_cast<long>(v) : v;
+    do {
+      digits[n++] = '0' + (u % 10);
+      u /= 10;
+    } while (u && n < sizeof(digits));
+    if (v < 0) { push('-'); }
+    while (n) { push(digits[--n]); }
+    return *this;
+  }
+
+  /**
+   * @brief Replace the buffer content; this is mostly here so `data = ""` in a
+   * URC handler keeps working.
+   */
+  TinyGsmResponseBuffer& operator=(const char* str) {
+    clear();
+    if (str) {
+      while (*str) { push(*str++); }
+    }
+    return *this;
+  }
+
+  size_t length() const {
+    return _len;
+  }
+
+  const char* c_str() const {
+    return _b;
+  }
+
+  char operator[](size_t i) const {
+    return i < _len ? _b[i] : '\0';
+  }
+
+  /**
+   * @brief Check if the buffer ends with the given string
+   *
+   * @param suffix The string to check for; may be in flash on AVR
+   * @return *true* The buffer ends with the suffix
+   * @return *false* The buffer does not end with the suffix, or the suffix is
+   * null
+   */
+  bool endsWith(GsmConstStr suffix) const {
+    if (!suffix) { return false; }
+    size_t len = TINY_GSM_PGM_LEN(suffix);
+    if (len > _len) { return false; }
+    const char* tail = _b + _len - len;
+    for (size_t i = 0; i < len; i++) {
+      if (tail[i] != TINY_GSM_PGM_CHAR(suffix, i)) { return false; }
+    }
+    return true;
+  }
+
+  /**
+   * @brief Find the first position of a character at or after a start point
+   *
+   * @return *int* The position of the character or -1 if not found
+   */
+  int indexOf(char c, int from = 0) const {
+    if (from < 0) { from = 0; }
+    for (size_t i = from; i < _len; i++) {
+      if (_b[i] == c) { return i; }
+    }
+    return -1;
+  }
+
+  /**
+   * @brief Find the last position of a (RAM) string starting at or before a
+   * given point
+   *
+   * @return *int* The position of the string or -1 if not found
+   */
+  int lastIndexOf(const char* str, int from) const {
+    int len = strlen(str);
+    if (len == 0 || len > static_cast<int>(_len)) { return -1; }
+    if (from > static_cast<int>(_len) - len) { from = _len - len; }
+    for (int i = from; i >= 0; i--) {
+      if (strncmp(_b + i, str, len) == 0) { return i; }
+    }
+    return -1;
+  }
+
+  int lastIndexOf(char c) const {
+    for (int i = _len - 1; i >= 0; i--) {
+      if (_b[i] == c) { return i; }
+    }
+    return -1;
+  }
+
+  /**
+   * @brief Parse an integer from a section of the buffer - the equivalent of
+   * String::substring(from, to).toInt() without the copy.
+   *
+   * @param from The first character to parse
+   * @param to One past the last character to parse; -1 for the end
+   * @return *int32_t* The parsed value, 0 if there are no digits
+   */
+  int32_t toInt(int from, int to = -1) const {
+    if (from < 0) { from = 0; }
+    if (to < 0 || to > static_cast<int>(_len)) { to = _len; }
+    while (from < to && (_b[from] == ' ' || _b[from] == '\r' ||
+                         _b[from] == '\n' || _b[from] == '\t')) {
+      from++;
+    }
+    bool neg = false;
+    if (from < to && (_b[from] == '-' || _b[from] == '+')) {
+      neg = _b[from] == '-';
+      from++;
+    }
+    int32_t res = 0;
+    while (from < to && _b[from] >= '0' && _b[from] <= '9') {
+      res = res * 10 + (_b[from++] - '0');
+    }
+    return neg ? -res : res;
+  }
+
+  /**
+   * @brief Remove any leading and trailing white space
+   */
+  void trim() {
+    size_t start = 0;
+    while (start < _len && isspace(static_cast<unsigned char>(_b[start]))) {
+      start++;
+    }
+    size_t end = _len;
+    while (end > start && isspace(static_cast<unsigned char>(_b[end - 1]))) {
+      end--;
+    }
+    _len = end - start;
+    if (start) { memmove(_b, _b + start, _len); }
+    _b[_len] = '\0';
+  }
+
+  /**
+   * @brief Move everything remaining in the buffer into the overflow sink, if
+   * there is one. The buffer is empty afterwards.
+   */
+  void flushToSink() {
+    if (_sink && _len) { *_sink += _b; }
+    _len  = 0;
+    _b[0] = '\0';
+  }
+
+ private:
+  // Drop (or sink) the oldest half of the buffer. Keeping the newest half
+  // means that any pattern shorter than N/2 that is in progress can still be
+  // matched against the end of the buffer.
+  void overflow() {
+    size_t keep = N / 2;
+    size_t drop = _len - keep;
+    if (_sink) {
+      // NOTE: String::concat(const char*, length) isn't public on all cores,
+      // so terminate the section being dropped and append that.
+      char saved = _b[drop];
+      _b[drop]   = '\0';
+      *_sink += _b;
+      _b[drop] = saved;
+    }
+    memmove(_b, _b + drop, keep);
+    _len = keep;
+  }
+
+  char    _b[N + 1];        ///< The buffer and space for a terminating null
+  size_t  _len  = 0;        ///< The number of characters in the buffer
+  String* _sink = nullptr;  ///< Where to put characters dropped on overflow
+};
+
+#ifndef TINY_GSM_RESPONSE_BUFFER
+// The number of characters of a response held while waiting for a match
+#define TINY_GSM_RESPONSE_BUFFER 64
+#endif
+
+typedef TinyGsmResponseBuffer<TINY_GSM_RESPONSE_BUFFER> TinyGsmResponse;
+
+#endif  // SRC_TINYGSMRESPONSEBUFFER_H_
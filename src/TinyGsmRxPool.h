@@ -0,0 +1,281 @@
+/**
+ * @file       TinyGsmRxPool.h
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ */
+
+#ifndef SRC_TINYGSMRXPOOL_H_
+#define SRC_TINYGSMRXPOOL_H_
+
+#include "TinyGsmCommon.h"
+
+#ifndef TINY_GSM_RX_POOL_BLOCK
+// The size of each block of the shared receive buffer pool
+#define TINY_GSM_RX_POOL_BLOCK 32
+#endif
+
+#ifndef TINY_GSM_RX_POOL_BLOCKS
+// The number of blocks in the shared receive buffer pool (at most 254)
+#define TINY_GSM_RX_POOL_BLOCKS 32
+#endif
+
+/**
+ * @brief The blocks all of the sockets' receive buffers are made of, when
+ * TINY_GSM_RX_POOL is defined.
+ *
+ * A socket only holds blocks while it has received data waiting to be read,
+ * so the memory goes to whichever sockets are busy instead of being set aside
+ * for every socket.
+ */
+class TinyGsmRxPool {
+ public:
+  static const uint8_t NONE = 0xFF;  ///< No block
+
+  /**
+   * @brief The pool shared by every socket
+   */
+  static TinyGsmRxPool& shared() {
+    static TinyGsmRxPool pool;
+    return pool;
+  }
+
+  /**
+   * @brief Take a block out of the pool
+   *
+   * @return *uint8_t* The block, or NONE if the pool is empty
+   */
+  uint8_t alloc() {
+    uint8_t b = _free;
+    if (b != NONE) {
+      _free     = _next[b];
+      _next[b]  = NONE;
+      _available--;
+    }
+    return b;
+  }
+
+  /**
+   * @brief Give a block, and every block linked after it, back to the pool
+   */
+  void release(uint8_t b) {
+    while (b != NONE) {
+      uint8_t n = _next[b];
+      _next[b]  = _free;
+      _free     = b;
+      _available++;
+      b = n;
+    }
+  }
+
+  /**
+   * @brief The number of blocks left in the pool
+   */
+  uint8_t available() const {
+    return _available;
+  }
+
+  uint8_t* data(uint8_t b) {
+    return _data[b];
+  }
+
+  uint8_t& next(uint8_t b) {
+    return _next[b];
+  }
+
+ private:
+  static_assert(TINY_GSM_RX_POOL_BLOCKS < NONE,
+                "TINY_GSM_RX_POOL_BLOCKS must be less than 255");
+  static_assert(TINY_GSM_RX_POOL_BLOCK < 256,
+                "TINY_GSM_RX_POOL_BLOCK must be less than 256");
+
+  TinyGsmRxPool() : _free(0), _available(TINY_GSM_RX_POOL_BLOCKS) {
+    for (uint8_t i = 0; i < TINY_GSM_RX_POOL_BLOCKS; i++) { _next[i] = i + 1; }
+    _next[TINY_GSM_RX_POOL_BLOCKS - 1] = NONE;
+  }
+
+  uint8_t _data[TINY_GSM_RX_POOL_BLOCKS][TINY_GSM_RX_POOL_BLOCK];
+  uint8_t _next[TINY_GSM_RX_POOL_BLOCKS];  ///< The block after each block
+  uint8_t _free;                           ///< The first free block
+  uint8_t _available;                      ///< The number of free blocks
+};
+
+/**
+ * @brief A socket's receive buffer borrowed block by block from the shared
+ * TinyGsmRxPool, with the same interface as TinyGsmFifo.
+ *
+ * The received data is kept in a chain of blocks; blocks are taken from the
+ * pool as data arrives and given back as soon as it has been read.
+ *
+ * @tparam N The most this buffer may hold, however much is left in the pool
+ */
+template <unsigned N>
+class TinyGsmPooledFifo {
+ public:
+  TinyGsmPooledFifo()
+      : _head(TinyGsmRxPool::NONE),
+        _tail(TinyGsmRxPool::NONE),
+        _r(0),
+        _w(0),
+        _count(0) {}
+
+  ~TinyGsmPooledFifo() {
+    clear();
+  }
+
+  // the blocks can only belong to one buffer
+  TinyGsmPooledFifo(const TinyGsmPooledFifo&)            = delete;
+  TinyGsmPooledFifo& operator=(const TinyGsmPooledFifo&) = delete;
+
+  /**
+   * @brief Throw away everything waiting and give the blocks back
+   */
+  void clear() {
+    TinyGsmRxPool::shared().release(_head);
+    _head  = TinyGsmRxPool::NONE;
+    _tail  = TinyGsmRxPool::NONE;
+    _r     = 0;
+    _w     = 0;
+    _count = 0;
+  }
+
+  // writing thread/context API
+  //-------------------------------------------------------------
+
+  bool writeable(void) {
+    return free() > 0;
+  }
+
+  /**
+   * @brief The number of items that can still be added; limited both by N
+   * and by what's left in the pool
+   */
+  int free(void) {
+    size_t room = TinyGsmRxPool::shared().available() *
+        static_cast<size_t>(TINY_GSM_RX_POOL_BLOCK);
+    if (_tail != TinyGsmRxPool::NONE) { room += TINY_GSM_RX_POOL_BLOCK - _w; }
+    return TinyGsmMin(room, static_cast<size_t>(N - _count));
+  }
+
+  bool put(const uint8_t& c) {
+    size_t   len;
+    uint8_t* span = writeSpan(len);
+    if (!len) return false;
+    *span = c;
+    commit(1);
+    return true;
+  }
+
+  int put(const uint8_t* p, int n, bool t = false) {
+    (void)t;  // blocking makes no sense when only reading can free space
+    int    c = 0;
+    size_t len;
+    while (c < n) {
+      uint8_t* span = writeSpan(len);
+      if (!len) break;
+      if (len > static_cast<size_t>(n - c)) len = n - c;
+      memcpy(span, p + c, len);
+      commit(len);
+      c += len;
+    }
+    return c;
+  }
+
+  uint8_t* writeSpan(size_t& len) {
+    len = 0;
+    if (_count >= N) { return nullptr; }
+    if (_tail == TinyGsmRxPool::NONE || _w == TINY_GSM_RX_POOL_BLOCK) {
+      uint8_t b = TinyGsmRxPool::shared().alloc();
+      if (b == TinyGsmRxPool::NONE) { return nullptr; }
+      if (_tail == TinyGsmRxPool::NONE) {
+        _head = b;
+        _r    = 0;
+      } else {
+        TinyGsmRxPool::shared().next(_tail) = b;
+      }
+      _tail = b;
+      _w    = 0;
+    }
+    len = TinyGsmMin(static_cast<size_t>(TINY_GSM_RX_POOL_BLOCK - _w),
+                     static_cast<size_t>(N - _count));
+    return TinyGsmRxPool::shared().data(_tail) + _w;
+  }
+
+  void commit(size_t n) {
+    _w += n;
+    _count += n;
+    if (!_count) { clear(); }  // don't hold on to a block that wasn't used
+  }
+
+  // reading thread/context API
+  // --------------------------------------------------------
+
+  bool readable(void) {
+    return _count > 0;
+  }
+
+  size_t size(void) {
+    return _count;
+  }
+
+  bool get(uint8_t* p) {
+    if (!_count) return false;
+    *p = TinyGsmRxPool::shared().data(_head)[_r];
+    consume(1);
+    return true;
+  }
+
+  int get(uint8_t* p, int n, bool t = false) {
+    (void)t;  // nothing can be received while waiting here
+    int    c = 0;
+    size_t len;
+    while (c < n) {
+      const uint8_t* span = readSpan(len);
+      if (!len) break;
+      if (len > static_cast<size_t>(n - c)) len = n - c;
+      memcpy(p + c, span, len);
+      consume(len);
+      c += len;
+    }
+    return c;
+  }
+
+  int peek() {
+    if (!_count) { return -1; }
+    return TinyGsmRxPool::shared().data(_head)[_r];
+  }
+
+  const uint8_t* readSpan(size_t& len) {
+    if (!_count) {
+      len = 0;
+      return nullptr;
+    }
+    len = (_head == _tail ? _w : TINY_GSM_RX_POOL_BLOCK) - _r;
+    return TinyGsmRxPool::shared().data(_head) + _r;
+  }
+
+  void consume(size_t n) {
+    _r += n;
+    _count -= n;
+    if (!_count) {
+      clear();
+    } else if (_r == TINY_GSM_RX_POOL_BLOCK) {
+      // the first block has been read out, give it back
+      uint8_t b = _head;
+      _head     = TinyGsmRxPool::shared().next(b);
+      TinyGsmRxPool::shared().next(b) = TinyGsmRxPool::NONE;
+      TinyGsmRxPool::shared().release(b);
+      _r = 0;
+    }
+  }
+
+ private:
+  uint8_t _head;   ///< The block being read
+  uint8_t _tail;   ///< The block being written
+  uint8_t _r;      ///< The read position in the first block
+  uint8_t _w;      ///< The write position in the last block
+  size_t  _count;  ///< The number of items waiting
+};
+
+#endif  // SRC_TINYGSMRXPOOL_H_
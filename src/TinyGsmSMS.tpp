@@ -10,6 +10,7 @@
 #define SRC_TINYGSMSMS_H_
 
 #include "TinyGsmCommon.h"
+#include "TinyGsmHex.h"
 
 #ifndef TINY_GSM_MODEM_HAS_SMS
 #define TINY_GSM_MODEM_HAS_SMS
@@ -58,13 +59,10 @@ class TinyGsmSMS {
     String result;
     byte   reminder = 0;
     int8_t bitstate = 7;
-    for (uint8_t i = 0; i < instr.length(); i += 2) {
-      char buf[4] = {
-          0,
-      };
-      buf[0] = instr[i];
-      buf[1] = instr[i + 1];
-      byte b = strtol(buf, nullptr, 16);
+    for (unsigned int i = 0; i + 1 < instr.length(); i += 2) {
+      int16_t v = TinyGsmHexByte(instr[i], instr[i + 1]);
+      if (v < 0) { break; }  // the septets after a bad pair can't be trusted
+      byte b = v;
 
       byte bb = b << (7 - bitstate);
       char c  = (bb + reminder) & 0x7F;
@@ -83,27 +81,19 @@ class TinyGsmSMS {
 
   static inline String TinyGsmDecodeHex8bit(const String& instr) {
     String result;
-    for (uint16_t i = 0; i < instr.length(); i += 2) {
-      char buf[4] = {
-          0,
-      };
-      buf[0] = instr[i];
-      buf[1] = instr[i + 1];
-      char b = strtol(buf, nullptr, 16);
-      result += b;
+    result.reserve(instr.length() / 2);
+    for (unsigned int i = 0; i + 1 < instr.length(); i += 2) {
+      int16_t b = TinyGsmHexByte(instr[i], instr[i + 1]);
+      if (b >= 0) { result += static_cast<char>(b); }
     }
     return result;
   }
 
   static inline String TinyGsmDecodeHex16bit(const String& instr) {
     String result;
-    for (uint16_t i = 0; i < instr.length(); i += 4) {
-      char buf[4] = {
-          0,
-      };
-      buf[0] = instr[i];
-      buf[1] = instr[i + 1];
-      char b = strtol(buf, nullptr, 16);
+    result.reserve(instr.length() / 4);
+    for (unsigned int i = 0; i + 3 < instr.length(); i += 4) {
+      int16_t b = TinyGsmHexByte(instr[i], instr[i + 1]);
       if (b) {  // If high byte is non-zero, we can't handle it ;(
 #if defined(TINY_GSM_UNICODE_TO_HEX)
         result += "\\x";
@@ -112,10 +102,8 @@ class TinyGsmSMS {
         result += "?";
 #endif
       } else {
-        buf[0] = instr[i + 2];
-        buf[1] = instr[i + 3];
-        b      = strtol(buf, nullptr, 16);
-        result += b;
+        b = TinyGsmHexByte(instr[i + 2], instr[i + 3]);
+        if (b >= 0) { result += static_cast<char>(b); }
       }
     }
     return result;
@@ -193,12 +181,11 @@ class TinyGsmSMS {
     Print&  p;
     uint8_t prv = 0;
     void    printHex(const uint16_t v) {
-      uint8_t c = v >> 8;
-      if (c < 0x10) p.print('0');
-      p.print(c, HEX);
-      c = v & 0xFF;
-      if (c < 0x10) p.print('0');
-      p.print(c, HEX);
+      const uint8_t b[2] = {static_cast<uint8_t>(v >> 8),
+                            static_cast<uint8_t>(v & 0xFF)};
+      char          hex[4];
+      TinyGsmHexEncode(b, 2, hex);
+      p.write(reinterpret_cast<const uint8_t*>(hex), sizeof(hex));
     }
   };
 
@@ -226,14 +213,20 @@ class TinyGsmSMS {
                          size_t len) {
     if (!sendSMS_UTF8_begin(number)) { return false; }
 
+    // encode and write the text a few characters at a time
     const uint16_t* t = reinterpret_cast<const uint16_t*>(text);
-    for (size_t i = 0; i < len; i++) {
-      uint8_t c = t[i] >> 8;
-      if (c < 0x10) { thisModem().stream.print('0'); }
-      thisModem().stream.print(c, HEX);
-      c = t[i] & 0xFF;
-      if (c < 0x10) { thisModem().stream.print('0'); }
-      thisModem().stream.print(c, HEX);
+    uint8_t         b[16];
+    char            hex[2 * sizeof(b)];
+    while (len) {
+      size_t n = TinyGsmMin(len, sizeof(b) / 2);
+      for (size_t i = 0; i < n; i++) {
+        b[2 * i]     = t[i] >> 8;
+        b[2 * i + 1] = t[i] & 0xFF;
+      }
+      TinyGsmHexEncode(b, 2 * n, hex);
+      thisModem().stream.write(reinterpret_cast<const uint8_t*>(hex), 4 * n);
+      t += n;
+      len -= n;
     }
 
     return sendSMS_UTF8_end();
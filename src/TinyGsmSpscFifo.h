@@ -0,0 +1,194 @@
+/**
+ * @file       TinyGsmSpscFifo.h
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ *
+ * @brief A circular buffer that one thread, task or interrupt can fill while
+ * another drains it, without locks.
+ *
+ * Nothing here is compiled unless the toolchain has <atomic>, so it's
+ * harmless on AVR builds.
+ */
+
+#ifndef SRC_TINYGSMSPSCFIFO_H_
+#define SRC_TINYGSMSPSCFIFO_H_
+
+#if defined(__has_include)
+#if __has_include(<atomic>)
+#define TINY_GSM_HAS_ATOMIC
+#endif
+#endif
+
+#ifdef TINY_GSM_HAS_ATOMIC
+
+#include <atomic>
+#include <string.h>
+
+/**
+ * @brief A single producer, single consumer circular buffer of N items of
+ * type T.
+ *
+ * It has the same interface as TinyGsmFifo, but exactly one context may call
+ * the writing functions and exactly one other context the reading functions,
+ * at the same time.  Each side only ever stores its own position, and
+ * publishes it with release ordering once the items are in place; the other
+ * side loads it with acquire ordering before touching those items.  So the
+ * writer can be a UART interrupt or a reader task while the application reads
+ * the data.
+ *
+ * As in the power of two TinyGsmFifo, the positions run freely and are masked
+ * on access, so all N positions can be used.
+ *
+ * @tparam T The type of the items; it should be trivially copyable
+ * @tparam N The number of items; it must be a power of two
+ */
+template <class T, unsigned N>
+class TinyGsmSpscFifo {
+  static_assert(N > 1 && (N & (N - 1)) == 0,
+                "The size of a TinyGsmSpscFifo must be a power of two");
+
+ public:
+  TinyGsmSpscFifo() : _w(0), _r(0) {}
+
+  // a copy couldn't be made atomically
+  TinyGsmSpscFifo(const TinyGsmSpscFifo&)            = delete;
+  TinyGsmSpscFifo& operator=(const TinyGsmSpscFifo&) = delete;
+
+  // writing thread/context API
+  //-------------------------------------------------------------
+
+  bool writeable(void) {
+    return free() > 0;
+  }
+
+  /**
+   * @brief The number of free positions; from the writing side this is a
+   * lower bound, as the reader may free more at any time.
+   */
+  int free(void) {
+    return N - (_w.load(std::memory_order_relaxed) -
+                _r.load(std::memory_order_acquire));
+  }
+
+  bool put(const T& c) {
+    unsigned w = _w.load(std::memory_order_relaxed);
+    if (w - _r.load(std::memory_order_acquire) == N) return false;  // full
+    _b[w & MASK] = c;
+    _w.store(w + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Add as many of the items as there's space for; this never blocks
+   *
+   * @return *int* The number of items added
+   */
+  int put(const T* p, int n) {
+    int    c = 0;
+    size_t len;
+    while (c < n) {
+      T* span = writeSpan(len);
+      if (!len) break;
+      if (len > static_cast<size_t>(n - c)) len = n - c;
+      memcpy(span, p + c, len * sizeof(T));
+      commit(len);
+      c += len;
+    }
+    return c;
+  }
+
+  T* writeSpan(size_t& len) {
+    unsigned w = _w.load(std::memory_order_relaxed);
+    unsigned f = N - (w - _r.load(std::memory_order_acquire));
+    unsigned i = w & MASK;
+    len        = f < N - i ? f : N - i;
+    return &_b[i];
+  }
+
+  void commit(size_t n) {
+    _w.store(_w.load(std::memory_order_relaxed) + n,
+             std::memory_order_release);
+  }
+
+  // reading thread/context API
+  // --------------------------------------------------------
+
+  bool readable(void) {
+    return size() > 0;
+  }
+
+  /**
+   * @brief The number of items waiting; from the reading side this is a
+   * lower bound, as the writer may add more at any time.
+   */
+  size_t size(void) {
+    return _w.load(std::memory_order_acquire) -
+        _r.load(std::memory_order_relaxed);
+  }
+
+  bool get(T* p) {
+    unsigned r = _r.load(std::memory_order_relaxed);
+    if (r == _w.load(std::memory_order_acquire)) return false;  // empty
+    *p = _b[r & MASK];
+    _r.store(r + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Take as many items as are waiting, up to n; this never blocks
+   *
+   * @return *int* The number of items taken
+   */
+  int get(T* p, int n) {
+    int    c = 0;
+    size_t len;
+    while (c < n) {
+      const T* span = readSpan(len);
+      if (!len) break;
+      if (len > static_cast<size_t>(n - c)) len = n - c;
+      memcpy(p + c, span, len * sizeof(T));
+      consume(len);
+      c += len;
+    }
+    return c;
+  }
+
+  int peek() {
+    unsigned r = _r.load(std::memory_order_relaxed);
+    if (r == _w.load(std::memory_order_acquire)) { return -1; }
+    return _b[r & MASK];
+  }
+
+  const T* readSpan(size_t& len) {
+    unsigned r = _r.load(std::memory_order_relaxed);
+    unsigned s = _w.load(std::memory_order_acquire) - r;
+    unsigned i = r & MASK;
+    len        = s < N - i ? s : N - i;
+    return &_b[i];
+  }
+
+  void consume(size_t n) {
+    _r.store(_r.load(std::memory_order_relaxed) + n,
+             std::memory_order_release);
+  }
+
+  /**
+   * @brief Throw away everything waiting; call this from the reading side
+   */
+  void clear() {
+    _r.store(_w.load(std::memory_order_acquire), std::memory_order_release);
+  }
+
+ private:
+  static const unsigned MASK = N - 1;
+
+  T                     _b[N]{};  /// The buffer
+  std::atomic<unsigned> _w;       /// Items ever written; only the writer sets
+  std::atomic<unsigned> _r;       /// Items ever read; only the reader sets
+};
+
+#endif  // TINY_GSM_HAS_ATOMIC
+
+#endif  // SRC_TINYGSMSPSCFIFO_H_
@@ -0,0 +1,224 @@
+/**
+ * @file       TinyGsmStats.h
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ */
+
+#ifndef SRC_TINYGSMSTATS_H_
+#define SRC_TINYGSMSTATS_H_
+
+#include "TinyGsmCommon.h"
+
+#ifndef TINY_GSM_STATS_COMMANDS
+// The number of different commands statistics are kept for; any others are
+// counted together as "*"
+#define TINY_GSM_STATS_COMMANDS 16
+#endif
+
+#ifndef TINY_GSM_STATS_PREFIX
+// The number of characters of a command kept to tell commands apart
+#define TINY_GSM_STATS_PREFIX 11
+#endif
+
+// The number of latency histogram buckets; bucket i counts latencies below
+// 2^i ms, and the last one everything longer
+#define TINY_GSM_STATS_BUCKETS 13
+
+/**
+ * @brief Statistics for one AT command.
+ *
+ * Commands are told apart by their name - the text up to the first '=', '?'
+ * or ';' - so "+CIPRXGET=2,1,1460" and "+CIPRXGET=4,1" count together.  The
+ * latency of a command runs from sending it to the end of the last response
+ * waited for before the next command.
+ */
+struct TinyGsmCommandStats {
+  char     prefix[TINY_GSM_STATS_PREFIX + 1];  ///< The command name
+  uint16_t count;       ///< The number of times the command was sent
+  uint16_t waits;       ///< The number of responses waited for
+  uint16_t timeouts;    ///< The number of waits that timed out
+  uint16_t errors;      ///< The number of "ERROR" responses
+  uint16_t cme_errors;  ///< The number of "+CME ERROR" / "+CMS ERROR"
+  uint32_t min_ms;      ///< The shortest latency
+  uint32_t max_ms;      ///< The longest latency
+  uint32_t total_ms;    ///< The sum of all latencies
+  uint16_t histogram[TINY_GSM_STATS_BUCKETS];  ///< Latencies by power of two
+
+  /**
+   * @brief The average latency, in ms
+   */
+  uint32_t mean() const {
+    return count ? total_ms / count : 0;
+  }
+
+  /**
+   * @brief An upper bound for a latency percentile, in ms, from the histogram
+   *
+   * @param pct The percentile; ie, 95
+   */
+  uint32_t percentile(uint8_t pct) const {
+    uint32_t want = (static_cast<uint32_t>(count) * pct + 99) / 100;
+    uint32_t seen = 0;
+    for (uint8_t i = 0; i < TINY_GSM_STATS_BUCKETS - 1; i++) {
+      seen += histogram[i];
+      if (seen >= want) {
+        return TinyGsmMin(static_cast<uint32_t>(1UL << i), max_ms);
+      }
+    }
+    return max_ms;
+  }
+};
+
+/**
+ * @brief Where the time talking to the module goes.
+ *
+ * Only collected when TINY_GSM_STATS is defined; see TinyGsmModem::getStats()
+ * and TinyGsmModem::dumpStats().
+ */
+class TinyGsmStats {
+ public:
+  TinyGsmStats() {
+    reset();
+  }
+
+  /**
+   * @brief Forget everything collected so far
+   */
+  void reset() {
+    memset(commands, 0, sizeof(commands));
+    used     = 0;
+    rx_bytes = 0;
+    tx_bytes = 0;
+    _open    = nullptr;
+    _waited  = false;
+  }
+
+  /**
+   * @brief The statistics for a command, by name; null if it hasn't been sent
+   */
+  const TinyGsmCommandStats* find(const char* prefix) const {
+    for (uint8_t i = 0; i < used; i++) {
+      if (!strcmp(commands[i].prefix, prefix)) { return &commands[i]; }
+    }
+    return nullptr;
+  }
+
+  /**
+   * @brief Print a table of everything collected so far
+   */
+  void dump(Print& out) const {
+    out.println(GF("command       count  waits  tmo  err  cme    min   mean"
+                   "    p95    max"));
+    for (uint8_t i = 0; i < used; i++) {
+      const TinyGsmCommandStats& c = commands[i];
+      out.print(c.prefix);
+      pad(out, strlen(c.prefix), 12);
+      printColumn(out, c.count, 7);
+      printColumn(out, c.waits, 7);
+      printColumn(out, c.timeouts, 5);
+      printColumn(out, c.errors, 5);
+      printColumn(out, c.cme_errors, 5);
+      printColumn(out, c.min_ms, 7);
+      printColumn(out, c.mean(), 7);
+      printColumn(out, c.percentile(95), 7);
+      printColumn(out, c.max_ms, 7);
+      out.println();
+    }
+    out.print(GF("bytes read: "));
+    out.print(rx_bytes);
+    out.print(GF(", written: "));
+    out.println(tx_bytes);
+  }
+
+  /**
+   * @brief Start timing a command
+   *
+   * @param prefix The name of the command, without the "AT"
+   * @param now The time it was sent
+   */
+  void begin(const char* prefix, uint32_t now) {
+    end();
+    _open   = entry(prefix);
+    _start  = now;
+    _waited = false;
+    _open->count++;
+  }
+
+  /**
+   * @brief Record the end of a wait for a response to the current command
+   *
+   * @param now The time the wait ended
+   * @param timeout Nothing expected was received
+   * @param error "ERROR" was received
+   * @param cme_error A verbose error was received
+   */
+  void response(uint32_t now, bool timeout, bool error, bool cme_error) {
+    if (!_open) { return; }
+    _end    = now;
+    _waited = true;
+    _open->waits++;
+    if (timeout) { _open->timeouts++; }
+    if (error) { _open->errors++; }
+    if (cme_error) { _open->cme_errors++; }
+  }
+
+  /**
+   * @brief Close the current command, adding its latency to its statistics
+   */
+  void end() {
+    if (!_open) { return; }
+    if (_waited) {
+      uint32_t ms = _end - _start;
+      if (_open->count == 1) { _open->min_ms = ms; }
+      _open->min_ms = TinyGsmMin(_open->min_ms, ms);
+      _open->max_ms = TinyGsmMax(_open->max_ms, ms);
+      _open->total_ms += ms;
+      uint8_t b = 0;
+      while (b < TINY_GSM_STATS_BUCKETS - 1 && ms >= (1UL << b)) { b++; }
+      _open->histogram[b]++;
+    } else {
+      // nobody waited for a response, so there's no latency to count
+      _open->count--;
+    }
+    _open = nullptr;
+  }
+
+  TinyGsmCommandStats commands[TINY_GSM_STATS_COMMANDS];  ///< By command
+  uint8_t             used;      ///< The number of commands in use
+  uint32_t            rx_bytes;  ///< Bytes read from the module
+  uint32_t            tx_bytes;  ///< Bytes written to the module
+
+ private:
+  TinyGsmCommandStats* entry(const char* prefix) {
+    for (uint8_t i = 0; i < used; i++) {
+      if (!strcmp(commands[i].prefix, prefix)) { return &commands[i]; }
+    }
+    // keep the last entry for everything that doesn't fit
+    if (used < TINY_GSM_STATS_COMMANDS - 1 || !strcmp(prefix, "*")) {
+      TinyGsmCommandStats* c = &commands[used++];
+      strncpy(c->prefix, prefix, TINY_GSM_STATS_PREFIX);
+      return c;
+    }
+    return entry("*");
+  }
+
+  static void pad(Print& out, size_t len, size_t width) {
+    for (; len < width; len++) { out.print(' '); }
+  }
+
+  static void printColumn(Print& out, uint32_t value, size_t width) {
+    char buf[11];
+    snprintf(buf, sizeof(buf), "%lu", static_cast<unsigned long>(value));
+    pad(out, strlen(buf), width);
+    out.print(buf);
+  }
+
+  TinyGsmCommandStats* _open;    ///< The command being timed
+  uint32_t             _start;   ///< When it was sent
+  uint32_t             _end;     ///< When the last wait for it ended
+  bool                 _waited;  ///< Whether anything waited for a response
+};
+
+#endif  // SRC_TINYGSMSTATS_H_
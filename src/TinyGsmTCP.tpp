@@ -16,6 +16,15 @@
 #endif
 
 #include "TinyGsmFifo.h"
+#include "TinyGsmHex.h"
+#include "TinyGsmIoVec.h"
+#include "TinyGsmResponseBuffer.h"
+#ifdef TINY_GSM_RX_POOL
+#include "TinyGsmRxPool.h"
+#endif
+#ifdef TINY_GSM_DNS_CACHE
+#include "TinyGsmDnsCache.h"
+#endif
 
 #if !defined(TINY_GSM_UNREAD_CHECK_MS)
 #define TINY_GSM_UNREAD_CHECK_MS 500
@@ -31,6 +40,40 @@
 #define TINY_GSM_SEND_MAX_SIZE 1500
 #endif
 
+#if !defined(TINY_GSM_READ_MAX_SIZE)
+// The most data the modem will give in answer to a single read command.  This
+// should be defined for each modem that keeps received data in a buffer; if
+// it's not, we'll assume the smallest limit seen on the supported modules.
+#define TINY_GSM_READ_MAX_SIZE 1024
+#endif
+
+// Modules that read in hex send two characters for every byte, and give a
+// separate, lower, limit for that read in TINY_GSM_READ_MAX_SIZE_HEX
+#if defined(TINY_GSM_USE_HEX) && defined(TINY_GSM_READ_MAX_SIZE_HEX)
+#define TINY_GSM_READ_LIMIT TINY_GSM_READ_MAX_SIZE_HEX
+#else
+#define TINY_GSM_READ_LIMIT TINY_GSM_READ_MAX_SIZE
+#endif
+
+#if !defined(TINY_GSM_STATUS_CACHE_MS)
+// How long the connection state found by refreshAllSockets() is used to answer
+// for a socket before the module is asked again; 0 asks every time
+#define TINY_GSM_STATUS_CACHE_MS 100
+#endif
+
+#if !defined(TINY_GSM_READ_AHEAD)
+// The number of reads maintain() may make for each socket, on modules that
+// keep received data in a buffer, to move that data into the socket's fifo
+// before the application asks for it; 0 leaves it with the module until read
+#define TINY_GSM_READ_AHEAD 0
+#endif
+
+#if defined(TINY_GSM_TX_BUFFER) && !defined(TINY_GSM_TX_IDLE_MS)
+// How long data may wait in a client's transmit buffer after the last write
+// before maintain() sends it
+#define TINY_GSM_TX_IDLE_MS 50
+#endif
+
 #if !defined(TINY_GSM_MIN_SEND_BUFFER)
 // This is the minimum amount of free send buffer space the modem must report
 // before attempting a send. If the minimum send buffer size is not defined,
@@ -66,8 +109,26 @@
 // // For modules that always use the mux you assign them
 // #define TINY_GSM_MUX_STATIC
 
+// A set of sockets, one bit for each place in a modem's sockets[]
+typedef uint16_t TinyGsmMuxMask;
+
+/**
+ * @brief The state of a set of sockets, as found by
+ * TinyGsmTCP::pollSockets()
+ */
+struct TinyGsmSocketEvents {
+  TinyGsmMuxMask readable;  ///< Data is waiting to be read
+  TinyGsmMuxMask writable;  ///< Connected and not in the middle of a write
+  TinyGsmMuxMask closed;    ///< No longer connected; data may still be waiting
+};
+
+template <class modemType, class clientType>
+class GsmUDP;
+
 template <class modemType, uint8_t muxCount, unsigned bufferSize>
 class TinyGsmTCP {
+  static_assert(muxCount <= 16, "TinyGsmMuxMask has room for 16 sockets");
+
   /* =========================================== */
   /* =========================================== */
   /*
@@ -78,7 +139,116 @@ class TinyGsmTCP {
    * Basic functions
    */
   void maintain() {
-    return thisModem().maintainImpl();
+#ifdef TINY_GSM_TX_BUFFER
+    // send anything that has sat in a transmit buffer for too long
+    for (int mux = 0; mux < muxCount; mux++) {
+      GsmClient* sock = thisModem().sockets[mux];
+      if (sock && sock->tx_len &&
+          millis() - sock->tx_last >= TINY_GSM_TX_IDLE_MS) {
+        sock->flushTx();
+      }
+    }
+#endif
+    thisModem().maintainImpl();
+#if TINY_GSM_READ_AHEAD > 0 && (defined TINY_GSM_BUFFER_READ_AND_CHECK_SIZE || \
+                                defined TINY_GSM_BUFFER_READ_NO_CHECK)
+    readAhead();
+#endif
+  }
+
+  /**
+   * @brief Find out which of a set of sockets need attention, with one pass
+   * over the serial link for all of them
+   *
+   * Each pass takes in any URCs (as maintain() does) and then looks at the
+   * state of every socket in the set, so the application only has to call
+   * available() or read() on the sockets that are ready.  It's named apart
+   * from poll(), which moves background commands along.
+   *
+   * @param mask The sockets to look at, by their place in the modem's
+   * sockets (usually the mux); all of them by default
+   * @param timeout_ms How long to keep looking while none of the sockets is
+   * readable or closed; 0 for a single pass
+   * @return *TinyGsmSocketEvents* The sockets in the set that are readable,
+   * writable and closed
+   */
+  TinyGsmSocketEvents pollSockets(TinyGsmMuxMask mask       = 0xFFFF,
+                                  uint32_t       timeout_ms = 0) {
+    TinyGsmSocketEvents events;
+    uint32_t            start = millis();
+    do {
+#if defined TINY_GSM_BUFFER_READ_AND_CHECK_SIZE
+      // Some modules "forget" to notify about data arrival, so ask about the
+      // sockets that are waiting on data, as available() would
+      for (uint8_t mux = 0; mux < muxCount; mux++) {
+        GsmClient* sock = thisModem().sockets[mux];
+        if ((mask >> mux & 1) && sock && sock->sock_connected &&
+            !sock->rx.size() && !sock->sock_available &&
+            millis() - sock->prev_check > TINY_GSM_UNREAD_CHECK_MS) {
+          flagSocket(mux);
+          sock->prev_check = millis();
+        }
+      }
+#endif
+      maintain();
+      events = socketEvents(mask);
+      if (events.readable || events.closed) { break; }
+      TINY_GSM_YIELD();
+    } while (millis() - start < timeout_ms);
+    return events;
+  }
+
+  /**
+   * @brief Update the connection state of every socket at once
+   *
+   * Modules that can list all of their connections do this with a single
+   * command; the others are asked about each socket in turn.  Until
+   * TINY_GSM_STATUS_CACHE_MS has passed, checking whether a socket is
+   * connected is answered from what was found here instead of asking again.
+   *
+   * @return *bool* Whether the module gave the state of its sockets
+   */
+  bool refreshAllSockets() {
+    if (!thisModem().refreshAllSocketsImpl()) { return false; }
+    sockets_refreshed = millis();
+    sockets_known     = true;
+    return true;
+  }
+
+  /**
+   * @brief Wait for the connections started by GsmClient::connectAsync() to
+   * be made or to fail
+   *
+   * URCs are taken in, as by maintain(), until none of the sockets in the set
+   * is still connecting.  Any that still are when the time runs out are
+   * closed.
+   *
+   * @param mask The sockets to wait for, by their place in the modem's
+   * sockets (usually the mux); all of them by default
+   * @param timeout_ms The longest to wait for all of them together
+   * @return *TinyGsmMuxMask* The sockets in the set that are connected
+   */
+  TinyGsmMuxMask waitConnects(TinyGsmMuxMask mask       = 0xFFFF,
+                              uint32_t       timeout_ms = 1000L *
+                                  TINY_GSM_CONNECT_TIMEOUT) {
+    uint32_t start = millis();
+    while (connectingSockets(mask) && millis() - start < timeout_ms) {
+      maintain();
+      TINY_GSM_YIELD();
+    }
+    TinyGsmMuxMask connected = 0;
+    for (uint8_t mux = 0; mux < muxCount; mux++) {
+      GsmClient*     sock = thisModem().sockets[mux];
+      TinyGsmMuxMask bit  = static_cast<TinyGsmMuxMask>(1U << mux);
+      if (!(mask & bit) || !sock) { continue; }
+      if (sock->is_connecting) {
+        DBG(GF("### Gave up connecting on"), mux);
+        sock->is_connecting = false;
+        sock->stop();
+      }
+      if (sock->sock_connected) { connected |= bit; }
+    }
+    return connected;
   }
 
   uint8_t findFirstUnassignedMux() {
@@ -95,15 +265,94 @@ class TinyGsmTCP {
 #if defined(TINY_GSM_MUX_STATIC)
   bool modemConnect(const char* host, uint16_t port, uint8_t mux,
                     int timeout_s = TINY_GSM_CONNECT_TIMEOUT) {
+#ifdef TINY_GSM_DNS_CACHE
+    String   addr;
+    uint32_t start = millis();
+    if (resolveHost(host, mux, addr, timeout_s * 1000UL)) {
+      if (thisModem().modemConnectImpl(addr.c_str(), port, mux,
+                                       timeoutLeft(timeout_s, start))) {
+        return true;
+      }
+      dns_cache.remove(host);  // the address may have changed
+      return false;
+    }
+#endif
     return thisModem().modemConnectImpl(host, port, mux, timeout_s);
   }
 #elif defined(TINY_GSM_MUX_DYNAMIC)
   bool modemConnect(const char* host, uint16_t port, uint8_t* mux,
                     int timeout_s = TINY_GSM_CONNECT_TIMEOUT) {
+#ifdef TINY_GSM_DNS_CACHE
+    String   addr;
+    uint32_t start = millis();
+    if (resolveHost(host, *mux, addr, timeout_s * 1000UL)) {
+      if (thisModem().modemConnectImpl(addr.c_str(), port, mux,
+                                       timeoutLeft(timeout_s, start))) {
+        return true;
+      }
+      dns_cache.remove(host);  // the address may have changed
+      return false;
+    }
+#endif
     return thisModem().modemConnectImpl(host, port, mux, timeout_s);
   }
 #else
 #error Modem client has been incorrectly created
+#endif
+  // Starts a connection and returns once the module has taken the command;
+  // the driver calls connectDone() when the result is reported.  Only a cached
+  // address is used: looking the host up here would wait for the lookup, so on
+  // a miss the module is given the host name and looks it up itself.
+  bool modemConnectAsync(const char* host, uint16_t port, uint8_t mux) {
+#ifdef TINY_GSM_DNS_CACHE
+    String addr;
+    if (resolveHost(host, mux, addr, 0)) {
+      return thisModem().modemConnectAsyncImpl(addr.c_str(), port, mux);
+    }
+#endif
+    return thisModem().modemConnectAsyncImpl(host, port, mux);
+  }
+
+#ifdef TINY_GSM_DNS_CACHE
+  /**
+   * @brief Find the address to connect to for a host name, from the cache or
+   * else by asking the module to look it up
+   *
+   * Secure sockets are always given the name, as the module needs it to
+   * check the server's certificate.
+   *
+   * @param host The host name, or an address as text
+   * @param mux The socket that will connect
+   * @param addr Set to the address as text
+   * @param timeout_ms The longest to wait for the module to look up the host;
+   * 0 to only use the cache
+   * @return *bool* Whether there's an address for the host; if not the host
+   * name is given to the module, which looks it up itself
+   */
+  bool resolveHost(const char* host, uint8_t mux, String& addr,
+                   uint32_t timeout_ms) {
+    GsmClient* sock = mux < muxCount ? thisModem().sockets[mux] : nullptr;
+    if (sock && sock->is_secure) { return false; }
+    IPAddress ip;
+    if (ip.fromString(host)) { return false; }  // nothing to look up
+    if (!dns_cache.find(host, ip)) {
+      if (!timeout_ms || !thisModem().modemResolveImpl(host, ip, timeout_ms)) {
+        return false;
+      }
+      dns_cache.add(host, ip);
+    }
+    addr = GsmClient::TinyGsmStringFromIp(ip);
+    return true;
+  }
+
+  // The part of a connection timeout left after looking up the host; at
+  // least a second, so the connection is still tried
+  static int timeoutLeft(int timeout_s, uint32_t start) {
+    int left = timeout_s - static_cast<int>((millis() - start) / 1000);
+    return left > 0 ? left : 1;
+  }
+
+  TinyGsmDnsCache<TINY_GSM_DNS_CACHE> dns_cache;
 #endif
 
   /**
@@ -122,6 +371,21 @@ class TinyGsmTCP {
   size_t modemSend(const uint8_t* buff, size_t len, uint8_t mux) {
     return thisModem().modemSendImpl(buff, len, mux);
   }
+  /**
+   * @brief Sends several buffers of data to the modem as one
+   *
+   * The buffers are packed into as few send commands as the send limit
+   * (TINY_GSM_SEND_MAX_SIZE, or less if the module says it has less space)
+   * allows, instead of at least one command per buffer.
+   *
+   * @param iov The buffers of data to send
+   * @param count The number of buffers
+   * @param mux The socket number
+   * @return The number of bytes sent
+   */
+  size_t modemSendv(const TinyGsmIoVec* iov, uint8_t count, uint8_t mux) {
+    return thisModem().modemSendvImpl(iov, count, mux);
+  }
   // Initiates the AT commands for a send, up to the point of getting an input
   // prompt
   bool modemBeginSend(size_t len, uint8_t mux) {
@@ -154,7 +418,17 @@ class TinyGsmTCP {
     return thisModem().modemGetAvailableImpl(mux);
   }
 #endif
+  // The mux is the socket's place in sockets[]; modules that number their
+  // connections differently convert before calling this
   bool modemGetConnected(uint8_t mux) {
+    if (mux >= muxCount) { return false; }
+#if TINY_GSM_STATUS_CACHE_MS > 0
+    GsmClient* sock = thisModem().sockets[mux];
+    if (sock && sockets_known &&
+        millis() - sockets_refreshed < TINY_GSM_STATUS_CACHE_MS) {
+      return sock->sock_connected;
+    }
+#endif
     return thisModem().modemGetConnectedImpl(mux);
   }
 
@@ -178,6 +452,8 @@ class TinyGsmTCP {
   class GsmClient : public Client {
     // Make all classes created from the modem template friends
     friend class TinyGsmTCP<modemType, muxCount, bufferSize>;
+    template <class, class>
+    friend class GsmUDP;
 
    public:
     // bool init(modemType* modem, uint8_t);
@@ -220,6 +496,17 @@ class TinyGsmTCP {
         // if we're in the middle of a write, pass directly to the stream
         return at->stream.write(buf, size);
       }
+#ifdef TINY_GSM_TX_BUFFER
+      // small writes only go into the transmit buffer until it's full, it's
+      // flushed, something is read or it has been idle for a while
+      if (tx_len + size < sizeof(tx_buf)) {
+        if (!sock_connected) { return 0; }
+        memcpy(tx_buf + tx_len, buf, size);
+        tx_len += size;
+        tx_last = millis();
+        return size;
+      }
+#endif
       TINY_GSM_YIELD();
       at->maintain();
 #if defined TINY_GSM_BUFFER_READ_AND_CHECK_SIZE
@@ -232,13 +519,51 @@ class TinyGsmTCP {
       // send.
       if (!sock_connected) { return 0; }
 #endif
+#ifdef TINY_GSM_TX_BUFFER
+      // send what's waiting along with the new data; if not even that all
+      // went, the rest of it stays in the buffer and none of the new data is
+      // written
+      TinyGsmIoVec iov[]   = {{tx_buf, tx_len}, {buf, size}};
+      size_t       waiting = tx_len;
+      size_t       sent    = at->modemSendv(iov, 2, mux);
+      if (sent < waiting) {
+        dropTx(sent);
+        return 0;
+      }
+      tx_len = 0;
+      return sent - waiting;
+#else
       return at->modemSend(buf, size, mux);
+#endif
     }
 
     size_t write(uint8_t c) override {
       return write(&c, 1);
     }
 
+    /**
+     * @brief Write several buffers, in RAM or in flash, with as few send
+     * commands as possible
+     *
+     * @param iov The buffers; see TinyGsmIoVec
+     * @param count The number of buffers
+     * @return *size_t* The number of bytes written
+     */
+    size_t writev(const TinyGsmIoVec* iov, uint8_t count) {
+      if (is_mid_send) {
+        return TinyGsmIoVecWrite(at->stream, iov, count, 0,
+                                 TinyGsmIoVecLength(iov, count));
+      }
+      TINY_GSM_YIELD();
+      at->maintain();
+#if defined TINY_GSM_BUFFER_READ_AND_CHECK_SIZE
+      if (!sock_connected) { return 0; }
+#endif
+      // the new data can't go ahead of what's already waiting
+      if (!flushTx()) { return 0; }
+      return at->modemSendv(iov, count, mux);
+    }
+
     size_t write(const char* str) {
       if (str == nullptr) return 0;
       return write(reinterpret_cast<const uint8_t*>(str), strlen(str));
@@ -247,6 +572,7 @@ class TinyGsmTCP {
     int available() override {
       is_mid_send = false;  // Any calls to the AT when mid-send will cause the
                             // send to fail
+      flushTx();
       TINY_GSM_YIELD();
 #if defined TINY_GSM_NO_MODEM_BUFFER
       // Returns the number of characters available in the TinyGSM fifo
@@ -265,9 +591,9 @@ class TinyGsmTCP {
       // with the modem to see if anything has arrived without a URC.
       if (!rx.size()) {
         if (millis() - prev_check > TINY_GSM_UNREAD_CHECK_MS) {
-          // setting got_data to true will tell maintain to run
+          // flagging the socket will tell maintain to run
           // modemGetAvailable(mux)
-          got_data   = true;
+          at->flagSocket(mux);
           prev_check = millis();
         }
         at->maintain();
@@ -283,6 +609,7 @@ class TinyGsmTCP {
       TINY_GSM_YIELD();
       is_mid_send = false;  // Any calls to the AT when mid-send will cause the
                             // send to fail
+      flushTx();
       size_t cnt = 0;
 
 #if defined TINY_GSM_NO_MODEM_BUFFER
@@ -298,14 +625,20 @@ class TinyGsmTCP {
           cnt += chunk;
           continue;
         }
-        // continue to parse URCs from the modem stream until the timeout
-        if (!rx.size() && sock_connected) { at->maintain(); }
+        // nothing more can arrive once the socket has closed
+        if (!sock_connected) { break; }
+        // continue to parse URCs from the modem stream until the timeout;
+        // maintain() returns at once when nothing has been received, so give
+        // way to anything else that needs to run (ie, the ESP8266 watchdog)
+        at->maintain();
+        if (!rx.size()) { TINY_GSM_YIELD(); }
       }
       return cnt;
 
 #elif defined TINY_GSM_BUFFER_READ_NO_CHECK
       // Reads characters out of the TinyGSM fifo, and from the modem chip's
       // internal fifo if available.
+      reading = true;  // read straight into buf rather than ahead
       while (cnt < size) {
         // Read out of the TinyGSM fifo
         size_t chunk = TinyGsmMin(size - cnt, rx.size());
@@ -316,22 +649,21 @@ class TinyGsmTCP {
           continue;
         }
         at->maintain();  // clear the modem stream/parse URCs
-        // Refill the TinyGSM fifo from the modem's internal buffer
-        // TODO: Read directly from modem into user buffer, skipping FIFO
+        // Read from the modem's internal buffer straight into the user buffer
         if (sock_available > 0) {
-          int n = at->modemRead(TinyGsmMin((uint16_t)rx.free(), sock_available),
-                                mux);
-          if (n == 0) break;
+          if (readFromModem(buf, cnt, size) == 0) break;
         } else {
           break;
         }
       }
+      reading = false;
       return cnt;
 
 #elif defined TINY_GSM_BUFFER_READ_AND_CHECK_SIZE
       // Reads characters out of the TinyGSM fifo, and from the modem chips
       // internal fifo if available, also double checking with the modem if
       // data has arrived without issuing a URC.
+      reading = true;  // read straight into buf rather than ahead
       while (cnt < size) {
         // Read out of the TinyGSM fifo
         size_t chunk = TinyGsmMin(size - cnt, rx.size());
@@ -343,23 +675,21 @@ class TinyGsmTCP {
         }
         // Workaround: Some modules "forget" to notify about data arrival
         if (millis() - prev_check > TINY_GSM_UNREAD_CHECK_MS) {
-          // setting got_data to true will tell maintain to run
+          // flagging the socket will tell maintain to run
           // modemGetAvailable()
-          got_data   = true;
+          at->flagSocket(mux);
           prev_check = millis();
         }
         at->maintain();  // clear the modem stream, parse URCs, run
                          // modemGetAvailable()
-        // Refill the TinyGSM fifo from the modem's internal buffer
-        // TODO: Read directly from modem into user buffer, skipping FIFO
+        // Read from the modem's internal buffer straight into the user buffer
         if (sock_available > 0) {
-          int n = at->modemRead(TinyGsmMin((uint16_t)rx.free(), sock_available),
-                                mux);
-          if (n == 0) break;
+          if (readFromModem(buf, cnt, size) == 0) break;
         } else {
           break;
         }
       }
+      reading = false;
       return cnt;
 
 #else
@@ -374,13 +704,40 @@ class TinyGsmTCP {
     }
 
     int peek() override {
+      flushTx();
       return rx.peek();
     }
 
+    // Anything in the transmit buffer that couldn't be sent stays there; call
+    // flushTx() instead to find out whether it all went
     void flush() override {
+      flushTx();
       at->stream.flush();
     }
 
+    /**
+     * @brief Send anything waiting in the transmit buffer; only does anything
+     * when TINY_GSM_TX_BUFFER is defined.
+     *
+     * This happens by itself when the buffer fills up, before anything is
+     * read, on flush() and stop(), and from maintain() once the buffer has
+     * been idle for TINY_GSM_TX_IDLE_MS.  Whatever isn't sent stays in the
+     * buffer to be tried again, until the client is stopped.
+     *
+     * @return *bool* Whether the buffer is now empty
+     */
+    bool flushTx() {
+#ifdef TINY_GSM_TX_BUFFER
+      if (!tx_len) { return true; }
+      if (is_mid_send || !sock_connected) { return false; }
+      TinyGsmIoVec iov(tx_buf, tx_len);
+      dropTx(at->modemSendv(&iov, 1, mux));
+      return !tx_len;
+#else
+      return true;
+#endif
+    }
+
     uint8_t connected() override {
       if (is_mid_send) { return true; }  // Don't interrupt a send
       if (available()) { return true; }
@@ -422,6 +779,39 @@ class TinyGsmTCP {
       return mux;
     }
 
+    /**
+     * @brief Start connecting to a host without waiting for the connection
+     * to be made
+     *
+     * On modules that report the result of a connection attempt by URC, this
+     * returns as soon as the module has taken the command, so several clients
+     * can be connecting at once; wait for all of them together with the
+     * modem's waitConnects().  Other modules connect before this returns, as
+     * connect() does.
+     *
+     * With TINY_GSM_DNS_CACHE, a host whose address is cached is connected to
+     * by that address; any other host name is given to the module to look up,
+     * so this never waits for a lookup, and the cache isn't filled by it.
+     *
+     * @param host The host name or IP address
+     * @param port The port
+     * @return *bool* Whether the connection has been started (or made)
+     */
+    bool connectAsync(const char* host, uint16_t port) {
+      return at->modemConnectAsync(host, port, mux);
+    }
+    bool connectAsync(IPAddress ip, uint16_t port) {
+      return connectAsync(TinyGsmStringFromIp(ip).c_str(), port);
+    }
+
+    /**
+     * @brief Whether a connection started by connectAsync() is still being
+     * made
+     */
+    bool connecting() {
+      return is_connecting;
+    }
+
     /**
      * @brief Begin writing to the modem client
      *
@@ -435,6 +825,7 @@ class TinyGsmTCP {
      * connection.
      */
     bool beginWrite(uint16_t size) {
+      flushTx();
       if (size > TINY_GSM_SEND_MAX_SIZE) {
         DBG(GF("### ERROR: You are attempting send"), size,
             GF("bytes, which is more than the"), TINY_GSM_SEND_MAX_SIZE,
@@ -468,6 +859,14 @@ class TinyGsmTCP {
     // Doing it this way allows the external mcu to find and get all of the
     // data that it wants from the socket even if it was closed externally.
     inline void dumpModemBuffer(uint32_t maxWaitMs) {
+      // the socket is about to close; get the last writes out, and throw away
+      // whatever can't be sent
+      if (!flushTx()) {
+        DBG(GF("### Unsent data dropped on"), mux);
+      }
+#ifdef TINY_GSM_TX_BUFFER
+      tx_len = 0;
+#endif
 #if defined TINY_GSM_BUFFER_READ_AND_CHECK_SIZE || \
     defined TINY_GSM_BUFFER_READ_NO_CHECK
       TINY_GSM_YIELD();
@@ -488,6 +887,28 @@ class TinyGsmTCP {
 #endif
     }
 
+#if defined TINY_GSM_BUFFER_READ_AND_CHECK_SIZE || \
+    defined TINY_GSM_BUFFER_READ_NO_CHECK
+    // Read from the modem's buffer for this socket, as much as the caller
+    // still wants plus what fits in the (empty) fifo.  The data goes straight
+    // into the caller's buffer and only the excess into the fifo, so a large
+    // read takes one command instead of one per fifo-full.
+    size_t readFromModem(uint8_t*& buf, size_t& cnt, size_t size) {
+      direct_buf  = buf;
+      direct_len  = size - cnt;
+      size_t want = TinyGsmMin(direct_len + rx.free(),
+                               static_cast<size_t>(sock_available));
+      want = TinyGsmMin(want, static_cast<size_t>(TINY_GSM_READ_LIMIT));
+      size_t n      = at->modemRead(want, mux);
+      size_t direct = size - cnt - direct_len;
+      buf += direct;
+      cnt += direct;
+      direct_buf = nullptr;
+      direct_len = 0;
+      return n;
+    }
+#endif
+
     modemType*                       at             = nullptr;
     uint8_t                          mux            = 0;
     uint16_t                         sock_available = 0;
@@ -495,8 +916,38 @@ class TinyGsmTCP {
     bool                             sock_connected = false;
     bool                             got_data       = false;
     bool                             is_secure      = false;
+    bool                             is_udp         = false;
     bool                             is_mid_send    = false;
+    bool                             is_connecting  = false;
+    uint16_t                         local_port     = 0;  // 0 for any (UDP)
+#ifdef TINY_GSM_RX_POOL
+    TinyGsmPooledFifo<bufferSize> rx;
+#else
     TinyGsmFifo<uint8_t, bufferSize> rx;
+#endif
+    // the caller's buffer while a read is in progress; received data goes
+    // there before the fifo
+    uint8_t* direct_buf = nullptr;
+    size_t   direct_len = 0;
+    bool     reading    = false;  // a read is in progress; don't read ahead
+#ifdef TINY_GSM_TX_BUFFER
+    static_assert(TINY_GSM_TX_BUFFER <= TINY_GSM_SEND_MAX_SIZE,
+                  "TINY_GSM_TX_BUFFER can't be more than one send");
+    // small writes collected to be sent together
+    uint8_t  tx_buf[TINY_GSM_TX_BUFFER];
+    size_t   tx_len  = 0;
+    uint32_t tx_last = 0;
+
+    // Take the first n bytes, which have been sent, out of the transmit buffer
+    void dropTx(size_t n) {
+      if (n >= tx_len) {
+        tx_len = 0;
+        return;
+      }
+      memmove(tx_buf, tx_buf + n, tx_len - n);
+      tx_len -= n;
+    }
+#endif
   };
 
   /* =========================================== */
@@ -509,15 +960,37 @@ class TinyGsmTCP {
    * Basic functions
    */
  protected:
+#if TINY_GSM_READ_AHEAD > 0 && (defined TINY_GSM_BUFFER_READ_AND_CHECK_SIZE || \
+                                defined TINY_GSM_BUFFER_READ_NO_CHECK)
+  // Move data the modem is holding for each socket into the free space of the
+  // socket's fifo, so the application's reads come straight from memory
+  void readAhead() {
+    for (int i = 0; i < muxCount; i++) {
+      GsmClient* sock = thisModem().sockets[i];
+      for (uint8_t n = 0; sock && !sock->reading && n < TINY_GSM_READ_AHEAD;
+           n++) {
+        size_t want = TinyGsmMin(static_cast<size_t>(sock->rx.free()),
+                                 static_cast<size_t>(sock->sock_available));
+        want = TinyGsmMin(want, static_cast<size_t>(TINY_GSM_READ_LIMIT));
+        if (!want || !thisModem().modemRead(want, sock->mux)) { break; }
+      }
+    }
+  }
+#endif
+
   void maintainImpl() {
 #if defined TINY_GSM_BUFFER_READ_AND_CHECK_SIZE
-    // Keep listening for modem URC's and proactively iterate through
-    // sockets asking if any data is available
-    for (int mux = 0; mux < muxCount; mux++) {
+    // Keep listening for modem URC's and ask how much data is waiting for
+    // only the sockets that have been flagged
+    TinyGsmMuxMask flagged = takeFlaggedSockets();
+    for (uint8_t mux = 0; flagged; mux++, flagged >>= 1) {
       GsmClient* sock = thisModem().sockets[mux];
-      if (sock && sock->got_data && sock->sock_available == 0) {
+      if (!(flagged & 1) || !sock || !sock->got_data) { continue; }
+      if (sock->sock_available == 0) {
         sock->got_data       = false;
         sock->sock_available = thisModem().modemGetAvailable(mux);
+      } else {
+        flagSocket(mux);  // ask again once what's known has been read
       }
     }
     while (thisModem().stream.available()) {
@@ -525,8 +998,10 @@ class TinyGsmTCP {
     }
 
 #elif defined TINY_GSM_NO_MODEM_BUFFER || defined TINY_GSM_BUFFER_READ_NO_CHECK
-    // Just listen for any URC's
-    thisModem().waitResponse(100, nullptr, nullptr);
+    // Just listen for any URC's, if anything has been received
+    while (thisModem().stream.available()) {
+      thisModem().waitResponse(15, nullptr, nullptr);
+    }
 
 #else
 #error Modem client has been incorrectly created
@@ -556,7 +1031,8 @@ class TinyGsmTCP {
   // If TINY_GSM_USE_HEX is defined, this will convert two received hex
   // characters into one char.
   size_t moveCharsFromStreamToFifo(uint8_t mux, size_t expected_len) {
-    if (!thisModem().sockets[mux]) { return false; }
+    GsmClient* sock = thisModem().sockets[mux];
+    if (!sock) { return false; }
     uint32_t startMillis   = millis();
     size_t   len           = expected_len;
     size_t   len_read      = 0;
@@ -572,29 +1048,59 @@ class TinyGsmTCP {
     // read operation
     while (len && char_failures < 3) {
       // if something is available, read it
-      if (thisModem().stream.available() >= READ_CHAR_LEN) {
+      int ready = thisModem().stream.available();
+      if (ready >= READ_CHAR_LEN) {
 #ifdef TINY_GSM_USE_HEX
-        // read 2 bytes and convert from hex to char
-        char buf[3] = {
-            0,
-        };
-        buf[0] = thisModem().stream.read();
-        buf[1] = thisModem().stream.read();
-        char c = strtol(buf, nullptr, 16);
+        // read all the whole pairs that are ready into the buffer of a read in
+        // progress, or else into the free space of the fifo, and decode them
+        // there; only a lone pair goes through a buffer of its own
+        size_t   n    = sock->direct_len;
+        uint8_t* span = n ? sock->direct_buf : sock->rx.writeSpan(n);
+        char     pair[2];
+        char*    hex   = n >= 2 ? reinterpret_cast<char*>(span) : pair;
+        size_t   pairs = TinyGsmMin(n >= 2 ? n / 2 : 1,
+                                    TinyGsmMin((len + 1) / 2,
+                                               static_cast<size_t>(ready) / 2));
+        size_t   got   = thisModem().stream.readBytes(hex, pairs * 2);
+        if (n) {
+          size_t c = TinyGsmHexDecode(hex, got, span);
+          if (c < got / 2) { DBG("### Invalid hex data dropped"); }
+          if (sock->direct_len) {
+            sock->direct_buf += c;
+            sock->direct_len -= c;
+          } else {
+            sock->rx.commit(c);
+          }
+        }  // else the fifo is full; the pair is lost
+        got = TinyGsmMin(got, len);
+        len -= got;
+        len_read += got;
 #else
-        // just read the character
-        char c = thisModem().stream.read();
-#endif
-        // NOTE: We can't directly memcpy into the rx fifo!
-        // The fifo is a template class that can hold any data type and the
-        // actual memory space of the buffer is protected.
-        thisModem().sockets[mux]->rx.put(c);
-        len -= READ_CHAR_LEN;
-        len_read += READ_CHAR_LEN;
+        // read everything that's ready straight into the buffer of a read in
+        // progress, or else into the free space of the fifo
+        size_t   n    = sock->direct_len;
+        uint8_t* span = n ? sock->direct_buf : sock->rx.writeSpan(n);
+        n = TinyGsmMin(n, TinyGsmMin(len, static_cast<size_t>(ready)));
+        if (n) {
+          n = thisModem().stream.readBytes(reinterpret_cast<char*>(span), n);
+          if (sock->direct_len) {
+            sock->direct_buf += n;
+            sock->direct_len -= n;
+          } else {
+            sock->rx.commit(n);
+          }
+        } else {
+          // the fifo is full; the character is lost
+          thisModem().stream.read();
+          n = 1;
+        }
+        len -= n;
+        len_read += n;
+#endif
       } else {
         // wait for a new character to be available on the stream
         while (thisModem().stream.available() < READ_CHAR_LEN &&
-               (millis() - startMillis < thisModem().sockets[mux]->_timeout)) {
+               (millis() - startMillis < sock->_timeout)) {
           TINY_GSM_YIELD();
         }
         if (thisModem().stream.available() < READ_CHAR_LEN) {
@@ -612,6 +1118,205 @@ class TinyGsmTCP {
   }
 #undef READ_CHAR_LEN
 
+  // Note that a socket (by its place in sockets[]) may have data waiting, for
+  // maintain() to follow up
+  void flagSocket(uint8_t i) {
+    if (i >= muxCount) { return; }
+    GsmClient* sock = thisModem().sockets[i];
+    if (sock) { sock->got_data = true; }
+    flagged_sockets |= static_cast<TinyGsmMuxMask>(1U << i);
+  }
+
+  // The state of a set of sockets as far as it's already known, without
+  // talking to the modem
+  TinyGsmSocketEvents socketEvents(TinyGsmMuxMask mask) {
+    TinyGsmSocketEvents events = {0, 0, 0};
+    for (uint8_t mux = 0; mux < muxCount; mux++) {
+      GsmClient*     sock = thisModem().sockets[mux];
+      TinyGsmMuxMask bit  = static_cast<TinyGsmMuxMask>(1U << mux);
+      if (!(mask & bit) || !sock) { continue; }
+#if defined TINY_GSM_NO_MODEM_BUFFER
+      if (sock->rx.size()) { events.readable |= bit; }
+#else
+      if (sock->rx.size() || sock->sock_available) { events.readable |= bit; }
+#endif
+      if (!sock->sock_connected) {
+        if (!sock->is_connecting) { events.closed |= bit; }
+      } else if (!sock->is_mid_send) {
+        events.writable |= bit;
+      }
+    }
+    return events;
+  }
+
+  // Record the result of a connection started by connectAsync()
+  void connectDone(int8_t mux, bool connected) {
+    GsmClient* sock = getURCSocket(mux);
+    if (!sock || !sock->is_connecting) { return; }
+    sock->is_connecting  = false;
+    sock->sock_connected = connected;
+    DBG(connected ? GF("### Connected:") : GF("### Failed to connect:"), mux);
+  }
+
+  // Wait for the result of a connection on a module that reports it as
+  // <mux>, CONNECT OK or <mux>, CONNECT FAIL.  A result for another socket
+  // that is still waiting on connectAsync() is recorded for that socket
+  // instead of being taken for this one.
+  bool waitConnectResult(uint8_t mux, uint32_t timeout_ms) {
+    uint32_t start = millis();
+    for (;;) {
+      uint32_t elapsed = millis() - start;
+      if (elapsed >= timeout_ms) { return false; }
+      TinyGsmResponse data;
+      int8_t          rsp = thisModem().waitResponseFor(
+          timeout_ms - elapsed, data, GF("CONNECT OK" AT_NL),
+          GF("CONNECT FAIL" AT_NL), GF("ALREADY CONNECT" AT_NL),
+          GF("ERROR" AT_NL),
+          GF("CLOSE OK" AT_NL));  // Happens when HTTPS handshake fails
+      if (rsp == 1 || rsp == 2) {
+        int8_t rsp_mux = getMuxInData(
+            data, rsp == 1 ? sizeof("CONNECT OK" AT_NL) - 1
+                           : sizeof("CONNECT FAIL" AT_NL) - 1);
+        GsmClient* other = getURCSocket(rsp_mux);
+        if (rsp_mux != mux && other && other->is_connecting) {
+          connectDone(rsp_mux, rsp == 1);
+          continue;
+        }
+      }
+      return rsp == 1;
+    }
+  }
+
+  // The sockets in a set that are still waiting on connectAsync()
+  TinyGsmMuxMask connectingSockets(TinyGsmMuxMask mask) {
+    TinyGsmMuxMask connecting = 0;
+    for (uint8_t mux = 0; mux < muxCount; mux++) {
+      GsmClient* sock = thisModem().sockets[mux];
+      if ((mask >> mux & 1) && sock && sock->is_connecting) {
+        connecting |= static_cast<TinyGsmMuxMask>(1U << mux);
+      }
+    }
+    return connecting;
+  }
+
+  // The sockets that have been flagged since the last call
+  TinyGsmMuxMask takeFlaggedSockets() {
+    TinyGsmMuxMask flagged = flagged_sockets;
+    flagged_sockets        = 0;
+    return flagged;
+  }
+
+  TinyGsmMuxMask flagged_sockets   = 0;
+  uint32_t       sockets_refreshed = 0;  // when refreshAllSockets() last ran
+  bool           sockets_known     = false;
+
+  /*
+   * Socket URC handlers
+   *
+   * These cover the most common forms of the socket URCs and can be used
+   * directly in a module's URC table.
+   */
+  // Get the socket for a mux number read from a URC, or nullptr if the mux is
+  // out of range or not in use
+  GsmClient* getURCSocket(int16_t mux) {
+    if (mux < 0 || mux >= muxCount) { return nullptr; }
+    return thisModem().sockets[mux];
+  }
+
+  // <mux>\n - new data is waiting in the modem's buffer
+  bool handleURCDataMux(TinyGsmResponse&) {
+    int8_t mux = thisModem().streamGetIntBefore('\n');
+    if (getURCSocket(mux)) { flagSocket(mux); }
+    DBG("### Got Data:", mux);
+    return true;
+  }
+
+  // 1,<mux>\n - new data is waiting in the modem's buffer
+  // The same text starts the responses to the commands for reading data, but
+  // those have a different mode number.
+  bool handleURCDataModeMux(TinyGsmResponse& data) {
+    int8_t mode = thisModem().streamGetIntBefore(',');
+    if (mode != 1) {
+      data += mode;
+      return false;
+    }
+    int8_t mux = thisModem().streamGetIntBefore('\n');
+    if (getURCSocket(mux)) { flagSocket(mux); }
+    // DBG("### Got Data:", mux);
+    return true;
+  }
+
+  // <mux>,<length>\n - data is waiting in the modem's buffer
+  bool handleURCDataMuxLen(TinyGsmResponse&) {
+    int8_t     mux  = thisModem().streamGetIntBefore(',');
+    int16_t    len  = thisModem().streamGetIntBefore('\n');
+    GsmClient* sock = getURCSocket(mux);
+    if (sock) {
+      flagSocket(mux);
+      // max size is 1024
+      if (len >= 0 && len <= 1024) { sock->sock_available = len; }
+    }
+    DBG("### Got Data:", len, "on", mux);
+    return true;
+  }
+
+  // <mux>\n - the socket has been closed
+  bool handleURCClosedMux(TinyGsmResponse&) {
+    closeURCSocket(thisModem().streamGetIntBefore('\n'));
+    return true;
+  }
+
+  // <mux>,<reason or other details>\n - the socket has been closed
+  bool handleURCClosedMuxFirst(TinyGsmResponse&) {
+    int8_t mux = thisModem().streamGetIntBefore(',');
+    thisModem().streamSkipUntil('\n');
+    closeURCSocket(mux);
+    return true;
+  }
+
+  // <mux>, CLOSED - the mux comes *before* the URC text, so it's already in
+  // the received data
+  bool handleURCClosedInData(TinyGsmResponse& data) {
+    closeURCSocket(getMuxInData(data, sizeof("CLOSED" AT_NL) - 1));
+    return true;
+  }
+
+  // <mux>,<error>\n - a connection started by connectAsync() has been made
+  // (error 0) or has failed
+  bool handleURCConnectMuxResult(TinyGsmResponse&) {
+    int8_t  mux = thisModem().streamGetIntBefore(',');
+    int16_t err = thisModem().streamGetIntBefore('\n');
+    connectDone(mux, err == 0);
+    return true;
+  }
+
+  // <mux>, CONNECT OK - the mux is in the received data, as for CLOSED
+  bool handleURCConnectOkInData(TinyGsmResponse& data) {
+    connectDone(getMuxInData(data, sizeof("CONNECT OK" AT_NL) - 1), true);
+    return true;
+  }
+
+  // <mux>, CONNECT FAIL
+  bool handleURCConnectFailInData(TinyGsmResponse& data) {
+    connectDone(getMuxInData(data, sizeof("CONNECT FAIL" AT_NL) - 1), false);
+    return true;
+  }
+
+  // The mux at the start of the line ending with a URC's text, for URCs of
+  // the form <mux>, <text>
+  int8_t getMuxInData(TinyGsmResponse& data, int16_t text_len) {
+    int8_t mux_start = TinyGsmMax(0, data.lastIndexOf(AT_NL, data.length() -
+                                                          text_len));
+    int8_t coma      = data.indexOf(',', mux_start);
+    return data.toInt(mux_start, coma);
+  }
+
+  void closeURCSocket(int8_t mux) {
+    GsmClient* sock = getURCSocket(mux);
+    if (sock) { sock->sock_connected = false; }
+    DBG("### Closed: ", mux);
+  }
+
 
 #if defined(TINY_GSM_MUX_STATIC)
   bool modemConnectImpl(const char* host, uint16_t port, uint8_t* mux,
@@ -623,12 +1328,28 @@ class TinyGsmTCP {
 #error Modem client has been incorrectly created
 #endif
 
+  // Modules without a command to look up a host name are always given the
+  // name, and look it up as they connect
+  bool modemResolveImpl(const char*, IPAddress&, uint32_t) {
+    return false;
+  }
+
+  // Modules that don't report the result of a connection attempt by URC
+  // connect while the caller waits, as GsmClient::connect() does
+  bool modemConnectAsyncImpl(const char* host, uint16_t port, uint8_t mux) {
+    GsmClient* sock = thisModem().sockets[mux];
+    return sock && sock->connect(host, port);
+  }
+
   size_t modemSendImpl(const uint8_t* buff, size_t len, uint8_t mux) {
-    // Pointer to where in the buffer we're up to
-    // A const cast is need to cast-away the constant-ness of the buffer (ie,
-    // modify it).
-    uint8_t* txPtr     = const_cast<uint8_t*>(buff);
-    size_t   bytesSent = 0;
+    TinyGsmIoVec iov(buff, len);
+    return thisModem().modemSendvImpl(&iov, 1, mux);
+  }
+
+  size_t modemSendvImpl(const TinyGsmIoVec* iov, uint8_t count, uint8_t mux) {
+    size_t len       = TinyGsmIoVecLength(iov, count);
+    size_t bytesSent = 0;
+    if (!len) { return 0; }
 
     do {
       // make no more than 3 attempts at the single send command
@@ -641,10 +1362,8 @@ class TinyGsmTCP {
           DBG(GF("### No available send buffer on attempt"), send_attempts);
           continue;
         }
-        // Ensure the program doesn't read past the allocated memory
-        if (txPtr + sendLength > const_cast<uint8_t*>(buff) + len) {
-          sendLength = const_cast<uint8_t*>(buff) + len - txPtr;
-        }
+        // Ensure the program doesn't read past the end of the data
+        sendLength = TinyGsmMin(sendLength, len - bytesSent);
         // start up a send command
         send_success = thisModem().modemBeginSend(sendLength, mux);
         if (!send_success) {
@@ -652,14 +1371,15 @@ class TinyGsmTCP {
           DBG(GF("### Failed to start send command on attempt"), send_attempts);
           continue;
         }
-        // write out the number of bytes for this chunk
-        int16_t attempted = thisModem().stream.write(
-            reinterpret_cast<const uint8_t*>(txPtr), sendLength);
+        // write out the number of bytes for this chunk, from as many of the
+        // buffers as it spans
+        int16_t attempted = TinyGsmIoVecWrite(thisModem().stream, iov, count,
+                                              bytesSent, sendLength);
         // let the transfer finish
         thisModem().stream.flush();
         // End this send command and check its responses
         // NOTE: In many cases, confirmed is just a passthrough of len
-        int16_t confirmed = thisModem().modemEndSend(len, mux);
+        int16_t confirmed = thisModem().modemEndSend(sendLength, mux);
 #if defined(TINY_GSM_DEBUG)
         if (confirmed < attempted) {
           DBG(GF("### Fewer bytes were confirmed ("), confirmed,
@@ -668,8 +1388,7 @@ class TinyGsmTCP {
         }
 #endif
         bytesSent += min(attempted,
-                         confirmed);         // bump up number of bytes sent
-        txPtr += min(attempted, confirmed);  // bump up the pointer
+                         confirmed);  // bump up number of bytes sent
         send_success &= min(attempted, confirmed) > 0;
         send_attempts++;
       }
@@ -729,6 +1448,18 @@ class TinyGsmTCP {
   size_t modemGetAvailableImpl(uint8_t mux) TINY_GSM_ATTR_NOT_IMPLEMENTED;
 #endif
   bool modemGetConnectedImpl(uint8_t mux) TINY_GSM_ATTR_NOT_IMPLEMENTED;
+
+  // Modules that can't list all of their connections at once are asked about
+  // each socket in turn
+  bool refreshAllSocketsImpl() {
+    for (uint8_t mux = 0; mux < muxCount; mux++) {
+      GsmClient* sock = thisModem().sockets[mux];
+      if (sock) {
+        sock->sock_connected = thisModem().modemGetConnectedImpl(sock->mux);
+      }
+    }
+    return true;
+  }
 };
 
 #endif  // SRC_TINYGSMTCP_H_
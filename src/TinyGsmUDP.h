@@ -0,0 +1,195 @@
+/**
+ * @file       TinyGsmUDP.h
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ */
+
+#ifndef SRC_TINYGSMUDP_H_
+#define SRC_TINYGSMUDP_H_
+
+#include "TinyGsmCommon.h"
+
+// Particle's UDP class has a different interface
+#if !defined(SPARK) && !defined(PARTICLE)
+
+#ifndef TINY_GSM_MODEM_HAS_UDP
+#define TINY_GSM_MODEM_HAS_UDP
+#endif
+
+#if defined(ARDUINO_DASH)
+#include <ArduinoCompat/Udp.h>
+#else
+#include <Udp.h>
+#endif
+
+#if !defined(TINY_GSM_UDP_PACKET_SIZE)
+// The largest datagram GsmUDP can send; it's collected in memory until
+// endPacket()
+#define TINY_GSM_UDP_PACKET_SIZE 512
+#endif
+
+/**
+ * @brief A UDP socket on the modem, with Arduino's UDP interface.
+ *
+ * It wraps one of the modem's clients, set up for UDP, so it takes a place in
+ * the modem's sockets like any other client and its received data goes
+ * through the same receive buffer.
+ *
+ * The module's socket is connected to the address given to beginPacket(), and
+ * stays connected while packets go to the same place; replies from there can
+ * be read with parsePacket().  The module doesn't say where one received
+ * datagram ends and the next starts, so parsePacket() gives everything that
+ * has arrived as one packet.
+ *
+ * @tparam modemType The modem
+ * @tparam clientType The modem's client; ie, TinyGsmClient
+ */
+template <class modemType, class clientType>
+class GsmUDP : public UDP {
+  static_assert(TINY_GSM_UDP_PACKET_SIZE <= TINY_GSM_SEND_MAX_SIZE,
+                "TINY_GSM_UDP_PACKET_SIZE can't be more than one send");
+
+ public:
+  GsmUDP() {
+    sock.is_udp = true;
+  }
+
+  explicit GsmUDP(modemType& modem, uint8_t mux = 0) : sock(modem, mux) {
+    sock.is_udp = true;
+  }
+
+  bool init(modemType* modem, uint8_t mux = 0) {
+    return sock.init(modem, mux);
+  }
+
+  /**
+   * @brief Set the local port the next connection is opened from, on modules
+   * that can choose it
+   *
+   * @return *uint8_t* 1
+   */
+  uint8_t begin(uint16_t port) override {
+    sock.local_port = port;
+    return 1;
+  }
+
+  void stop() override {
+    sock.stop();
+    remote_host = "";
+    remote_ip   = IPAddress(0, 0, 0, 0);
+    remote_port = 0;
+    tx_len      = 0;
+  }
+
+  /**
+   * @brief Start a packet to a host; the socket is connected to it unless
+   * it's already connected there
+   *
+   * @return *int* 1 if the socket is connected, 0 if not
+   */
+  int beginPacket(const char* host, uint16_t port) override {
+    tx_len = 0;
+    if (sock.connected() && port == remote_port && remote_host == host) {
+      return 1;
+    }
+    remote_host = host;
+    remote_port = port;
+    if (!remote_ip.fromString(host)) { remote_ip = IPAddress(0, 0, 0, 0); }
+    return sock.connect(host, port);
+  }
+
+  int beginPacket(IPAddress ip, uint16_t port) override {
+    return beginPacket(clientType::TinyGsmStringFromIp(ip).c_str(), port);
+  }
+
+  /**
+   * @brief Send the packet
+   *
+   * @return *int* 1 if the whole packet was sent, 0 if not
+   */
+  int endPacket() override {
+    size_t len = tx_len;
+    tx_len     = 0;
+    if (!len) { return 0; }
+    size_t sent = sock.write(tx_buf, len);
+    sock.flush();
+    return sent == len;
+  }
+
+  size_t write(uint8_t c) override {
+    return write(&c, 1);
+  }
+
+  /**
+   * @brief Add to the packet
+   *
+   * @return *size_t* The number of bytes added; less than size once the
+   * packet reaches TINY_GSM_UDP_PACKET_SIZE
+   */
+  size_t write(const uint8_t* buf, size_t size) override {
+    size_t n = TinyGsmMin(size, sizeof(tx_buf) - tx_len);
+    memcpy(tx_buf + tx_len, buf, n);
+    tx_len += n;
+    return n;
+  }
+
+  using Print::write;
+
+  /**
+   * @brief Check for received data
+   *
+   * @return *int* The number of bytes received and not yet read
+   */
+  int parsePacket() override {
+    return sock.available();
+  }
+
+  int available() override {
+    return sock.available();
+  }
+
+  int read() override {
+    return sock.read();
+  }
+
+  int read(unsigned char* buf, size_t len) override {
+    return sock.read(buf, len);
+  }
+
+  int read(char* buf, size_t len) override {
+    return sock.read(reinterpret_cast<uint8_t*>(buf), len);
+  }
+
+  int peek() override {
+    return sock.peek();
+  }
+
+  // packets are sent by endPacket(); there's nothing to wait for
+  void flush() override {}
+
+  /**
+   * @brief The address packets are sent to and read from; 0.0.0.0 if it was
+   * given as a host name
+   */
+  IPAddress remoteIP() override {
+    return remote_ip;
+  }
+
+  uint16_t remotePort() override {
+    return remote_port;
+  }
+
+ protected:
+  clientType sock;
+  String     remote_host;
+  IPAddress  remote_ip;
+  uint16_t   remote_port = 0;
+  uint8_t    tx_buf[TINY_GSM_UDP_PACKET_SIZE];
+  size_t     tx_len = 0;
+};
+
+#endif  // !SPARK && !PARTICLE
+
+#endif  // SRC_TINYGSMUDP_H_